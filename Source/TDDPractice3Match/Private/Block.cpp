@@ -1,9 +1,24 @@
 #include "../Public/Block.h"
+#include "../Public/ExplosionMask.h"
 
 
 uint32 GetTypeHash(const Block& block)
 {
-	return (1 + static_cast<int>(block.GetColor())) * (1 + static_cast<int>(block.GetSpecialAttribute()));
+	return block.Pack();
+}
+
+FArchive& operator<<(FArchive& archive, Block& block)
+{
+	auto packedBlock = block.Pack();
+	archive << packedBlock;
+	if (archive.IsLoading()) {
+		const auto color = packedBlock & 0x7;
+		const auto specialAttribute = (packedBlock >> 3) & 0x7;
+		if (color > static_cast<uint8>(BlockColor::INVALID) || specialAttribute > static_cast<uint8>(BlockSpecialAttribute::INVALID))
+			archive.SetError();
+		block = Block(static_cast<BlockColor>(color), static_cast<BlockSpecialAttribute>(specialAttribute));
+	}
+	return archive;
 }
 
 FString PrettyPrint(Block block)
@@ -41,6 +56,18 @@ TArray<Block> GetNormalBlocks() {
 	return ret;
 }
 
+void Block::AddExplosionTo(ExplosionMask& explosionMask, FIntPoint cell) const
+{
+	if (specialAttribute == BlockSpecialAttribute::VERTICAL_LINE_CLEAR)
+		explosionMask.AddColumn(cell.Y);
+	else if (specialAttribute == BlockSpecialAttribute::HORIZONTAL_LINE_CLEAR)
+		explosionMask.AddRow(cell.X);
+	else if (specialAttribute == BlockSpecialAttribute::DIAMOND_NEIGHBORHOOD_CLEAR)
+		explosionMask.AddDiamond(cell, DIAMOND_CLEAR_RADIUS);
+	else if (specialAttribute == BlockSpecialAttribute::ONE_COLOR_CLEAR)
+		explosionMask.AddColor(color);
+}
+
 bool Block::operator==(const Block& otherBlock) const
 {
 	return (color == otherBlock.color) && (specialAttribute == otherBlock.specialAttribute);
@@ -3,6 +3,68 @@
 #include "../Public/BlockAction.h"
 #include "../Public/BlockPhysics.h"
 #include "../Public/MyMathUtils.h"
+#include "../Public/BlockPhysicsStats.h"
+
+namespace {
+	// Narrows [begin, end) to the steps i for which start + stepSize * i lies in [0, size); stepSize is -1, 0 or 1
+	void ClipSteps(int start, int stepSize, int size, int& begin, int& end)
+	{
+		if (stepSize == 0) {
+			if (start < 0 || start >= size)
+				end = begin;
+			return;
+		}
+		const auto firstStepInside = stepSize > 0 ? -start : start - (size - 1);
+		const auto lastStepInside = stepSize > 0 ? size - 1 - start : start;
+		begin = FGenericPlatformMath::Max(begin, firstStepInside);
+		end = FGenericPlatformMath::Min(end, lastStepInside + 1);
+	}
+}
+
+SweptSegment SweptSegment::ClipTo(int numRows, int numCols) const
+{
+	auto begin = 0;
+	auto end = numCells;
+	ClipSteps(firstCell.X, step.X, numRows, begin, end);
+	ClipSteps(firstCell.Y, step.Y, numCols, begin, end);
+	if (end <= begin)
+		return SweptSegment();
+	auto ret = SweptSegment();
+	ret.firstCell = firstCell + step * begin;
+	ret.step = step;
+	ret.numCells = end - begin;
+	return ret;
+}
+
+BlockAction::BlockAction(FVector2D initialPos)
+	:position(initialPos)
+{
+	BLOCK_PHYSICS_COUNT(ActionAllocations, 1);
+}
+
+TUniquePtr<BlockAction> BlockAction::CreateForLoading(BlockActionClass actionClass, BlockPhysics& blockPhysics, BlockHandle handle)
+{
+	switch (actionClass) {
+	case BlockActionClass::Idle:
+		return MakeUnique<IdleBlockAction>(FVector2D::ZeroVector);
+	case BlockActionClass::SwipeMove:
+		return MakeUnique<SwipeMoveBlockAction>(FIntPoint::ZeroValue, FIntPoint::ZeroValue);
+	case BlockActionClass::SwipeReturn:
+		return MakeUnique<SwipeReturnBlockAction>(FIntPoint::ZeroValue, FIntPoint::ZeroValue);
+	case BlockActionClass::Fall:
+		return MakeUnique<FallingBlockAction>(FIntPoint::ZeroValue, FIntPoint::ZeroValue);
+	case BlockActionClass::GetsDestroyed:
+		return MakeUnique<GetsDestroyedBlockAction>(FVector2D::ZeroVector);
+	case BlockActionClass::GetsDestroyedAndSpawnBlockAfter:
+		return MakeUnique<GetsDestroyedAndSpawnBlockAfterAction>(FVector2D::ZeroVector, Block::INVALID);
+	case BlockActionClass::Roll:
+		return MakeUnique<MunchickenRollAction>(FVector2D::ZeroVector, FIntPoint(0, 1), blockPhysics, handle);
+	case BlockActionClass::GetsDestroyedInBackground:
+		return MakeUnique<GetsDestroyedInBackgroundBlockAction>(FVector2D::ZeroVector);
+	default:
+		return nullptr;
+	}
+}
 
 void GetsDestroyedBlockAction::Tick(float deltaSeconds)
 {
@@ -11,6 +73,12 @@ void GetsDestroyedBlockAction::Tick(float deltaSeconds)
 		completed = true;
 }
 
+void GetsDestroyedBlockAction::Serialize(FArchive& archive)
+{
+	BlockAction::Serialize(archive);
+	archive << elapsedTime << completed;
+}
+
 SwipeMoveBlockAction::SwipeMoveBlockAction(FIntPoint initialPos, FIntPoint destPos)
 	: BlockAction(initialPos), initialPos(initialPos), destPos(destPos)
 {
@@ -32,6 +100,12 @@ void SwipeMoveBlockAction::Tick(float deltaSeconds)
 	}
 }
 
+void SwipeMoveBlockAction::Serialize(FArchive& archive)
+{
+	BlockAction::Serialize(archive);
+	archive << initialPos << destPos << isJustCompleted;
+}
+
 TUniquePtr<BlockAction> SwipeMoveBlockAction::GetNextAction(bool thereIsAMatch) const
 {
 	if (thereIsAMatch) {
@@ -65,6 +139,12 @@ void FallingBlockAction::Tick(float deltaSeconds)
 	currentSpeed += deltaSeconds * BlockPhysics::GRAVITY_ACCELERATION;
 }
 
+void FallingBlockAction::Serialize(FArchive& archive)
+{
+	BlockAction::Serialize(archive);
+	archive << initialPos << destPos << currentSpeed << isJustCompleted;
+}
+
 SwipeReturnBlockAction::SwipeReturnBlockAction(FIntPoint initialPos, FIntPoint destPos)
 	: BlockAction(initialPos), initialPos(initialPos), destPos(destPos)
 {
@@ -86,6 +166,12 @@ void SwipeReturnBlockAction::Tick(float deltaSeconds)
 	}
 }
 
+void SwipeReturnBlockAction::Serialize(FArchive& archive)
+{
+	BlockAction::Serialize(archive);
+	archive << initialPos << destPos << isJustCompleted;
+}
+
 FString PrettyPrint(ActionType actionType)
 {
 	switch (actionType) {
@@ -99,6 +185,8 @@ FString PrettyPrint(ActionType actionType)
 		return TEXT("Fall");
 	case ActionType::GetsDestroyed:
 		return TEXT("GetsDestroyed");
+	case ActionType::Roll:
+		return TEXT("Roll");
 	default:
 		return TEXT("");
 	}
@@ -115,15 +203,21 @@ TUniquePtr<BlockAction> GetsDestroyedAndSpawnBlockAfterAction::GetNextAction(boo
 	return MakeUnique<IdleBlockAction>(position);
 }
 
-MunchickenRollAction::MunchickenRollAction(FVector2D initialPos, FIntPoint rollDirection, BlockPhysics& blockPhysics, int rollableId)
-	: BlockAction(initialPos), lastRolledOverPosition(BlockPhysics::ToFIntPoint(initialPos)), rollDirection(rollDirection), blockPhysics(blockPhysics), rollableId(rollableId)
+void GetsDestroyedAndSpawnBlockAfterAction::Serialize(FArchive& archive)
+{
+	GetsDestroyedBlockAction::Serialize(archive);
+	archive << blockToSpawnAfterDestroy;
+}
+
+MunchickenRollAction::MunchickenRollAction(FVector2D initialPos, FIntPoint rollDirection, BlockPhysics& blockPhysics, BlockHandle rollableHandle)
+	: BlockAction(initialPos), previousPosition(initialPos), lastRolledOverPosition(BlockPhysics::ToFIntPoint(initialPos)), rollDirection(rollDirection), blockPhysics(blockPhysics), rollableHandle(rollableHandle)
 {
 	if (rollDirection.X == 0)
 		rollType = Horizontal;
 	else if (rollDirection.Y == 0)
 		rollType = Vertical;
 	else {
-		UE_LOG(LogTemp, Warning, TEXT("Initialized MunchickenRollAction with wrong rollDirection: (%d, %d)"), rollDirection.X, rollDirection.Y);
+		UE_LOG(LogBlockPhysics, Warning, TEXT("Initialized MunchickenRollAction with wrong rollDirection: (%d, %d)"), rollDirection.X, rollDirection.Y);
 		rollType = Invalid;
 	}
 }
@@ -132,10 +226,10 @@ void MunchickenRollAction::Tick(float deltaSeconds)
 {
 	previousPosition = position;
 	UpdatePosition(deltaSeconds);
-	const auto cellPositionsRolledOver = GetCellPositionsRolledOver();
-	for (const auto& rolledOverPosition : cellPositionsRolledOver)
-		lastRolledOverPosition = rolledOverPosition;
-	ApplyRollOverEffectAt(cellPositionsRolledOver);
+	// BlockPhysics applies the roll over effect once every block has ticked.
+	const auto sweptSegment = GetSweptSegment();
+	if (sweptSegment.numCells > 0)
+		lastRolledOverPosition = sweptSegment.firstCell + sweptSegment.step * (sweptSegment.numCells - 1);
 }
 
 bool MunchickenRollAction::IsJustCompleted() const
@@ -163,61 +257,53 @@ ActionType MunchickenRollAction::GetType() const
 	return ActionType::Roll;
 }
 
-void MunchickenRollAction::UpdatePosition(float deltaSeconds)
+TUniquePtr<BlockAction> MunchickenRollAction::Clone(BlockPhysics& owner) const
 {
-	const auto rollDistance = BlockPhysics::ROLL_SPEED * deltaSeconds;
-	position += FVector2D(rollDirection) * rollDistance;
+	auto ret = MakeUnique<MunchickenRollAction>(position, rollDirection, owner, rollableHandle);
+	ret->previousPosition = previousPosition;
+	ret->lastRolledOverPosition = lastRolledOverPosition;
+	ret->rollType = rollType;
+	return ret;
 }
 
-TSet<FIntPoint> MunchickenRollAction::GetCellPositionsRolledOver() const
+void MunchickenRollAction::Serialize(FArchive& archive)
 {
-	TSet<FIntPoint> ret;
-	switch (rollType) {
-	case Horizontal: {
-		const auto movingRow = BlockPhysics::ToFIntPoint(position).X;
-		const auto rolledOverCols = GetIntegersBetween(previousPosition.Y, position.Y);
-		for (const auto& rolledOverCol : rolledOverCols) {
-			const auto rolledOverCellPos = FIntPoint{ movingRow, rolledOverCol };
-			ret.Add(rolledOverCellPos);
-		}
-		break;
-	}
-	case Vertical: {
-		const auto movingCol = BlockPhysics::ToFIntPoint(position).Y;
-		const auto rolledOverRows = GetIntegersBetween(previousPosition.X, position.X);
-		for (const auto& rolledOverRow : rolledOverRows) {
-			const auto rolledOverCellPos = FIntPoint{ rolledOverRow, movingCol };
-			ret.Add(rolledOverCellPos);
-		}
-		break;
-	}
-	default: {
-	}
+	BlockAction::Serialize(archive);
+	auto rollTypeValue = static_cast<uint8>(rollType);
+	archive << previousPosition << lastRolledOverPosition << rollDirection << rollTypeValue;
+	if (archive.IsLoading()) {
+		if (rollTypeValue > Horizontal)
+			archive.SetError();
+		rollType = static_cast<RollType>(rollTypeValue);
 	}
-	return ret;
 }
 
-TSet<int> MunchickenRollAction::GetIntegersBetween(float bound1, float bound2)
+void MunchickenRollAction::UpdatePosition(float deltaSeconds)
 {
-	// Want to output N s.t. lowerBound <= N < upperBound
-
-	float lowerBound = FGenericPlatformMath::Min(bound1, bound2);
-	float upperBound = FGenericPlatformMath::Max(bound1, bound2);
-	int lowerIntBound = FGenericPlatformMath::CeilToInt(lowerBound);
-	int upperIntBound = FGenericPlatformMath::CeilToInt(upperBound);
-
-	TSet<int> ret;
-	for (int i = lowerIntBound; i < upperIntBound; i++)
-		ret.Add(i);
-	return ret;
+	const auto rollDistance = BlockPhysics::ROLL_SPEED * deltaSeconds;
+	position += FVector2D(rollDirection) * rollDistance;
 }
 
-void MunchickenRollAction::ApplyRollOverEffectAt(const TSet<FIntPoint>& destroyPositions)
+SweptSegment MunchickenRollAction::GetSweptSegment() const
 {
-	for (const auto& destroyPosition : destroyPositions) {
-		UE_LOG(LogTemp, Display, TEXT("destroyed by munchicken at (%d, %d)"), destroyPosition.X, destroyPosition.Y);
-	}
-	blockPhysics.ApplyRollOverEffectAt(destroyPositions, TSet<int>{rollableId}, rollDirection);
+	if (rollType == Invalid)
+		return SweptSegment();
+	// Cells N with lowerBound <= N < upperBound along the rolling axis
+	const auto isHorizontal = rollType == Horizontal;
+	const auto previousCoordinate = isHorizontal ? previousPosition.Y : previousPosition.X;
+	const auto coordinate = isHorizontal ? position.Y : position.X;
+	const auto lowerIntBound = FGenericPlatformMath::CeilToInt(FGenericPlatformMath::Min(previousCoordinate, coordinate));
+	const auto upperIntBound = FGenericPlatformMath::CeilToInt(FGenericPlatformMath::Max(previousCoordinate, coordinate));
+	if (upperIntBound <= lowerIntBound)
+		return SweptSegment();
+	const auto isRollingForward = rollDirection.X + rollDirection.Y > 0;
+	const auto firstCoordinate = isRollingForward ? lowerIntBound : upperIntBound - 1;
+	const auto movingLine = BlockPhysics::ToFIntPoint(position);
+	auto ret = SweptSegment();
+	ret.firstCell = isHorizontal ? FIntPoint{ movingLine.X, firstCoordinate } : FIntPoint{ firstCoordinate, movingLine.Y };
+	ret.step = rollDirection;
+	ret.numCells = upperIntBound - lowerIntBound;
+	return ret;
 }
 
 bool MunchickenRollAction::IsOutOfTheMap() const
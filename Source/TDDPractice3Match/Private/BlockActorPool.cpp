@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BlockActorPool.h"
+#include "GameFramework/Actor.h"
+#include "PaperFlipbookComponent.h"
+#include "BlockPhysicsStats.h"
+
+void BlockActorPool::Reset(int numKinds)
+{
+	DestroyFreeActors();
+	freeActorsPerKind.SetNum(numKinds);
+	numHits = 0;
+	numMisses = 0;
+}
+
+AActor* BlockActorPool::Acquire(int kind, const FVector& location, const FRotator& rotation)
+{
+	auto& freeActors = freeActorsPerKind[kind];
+	// Actors destroyed behind the pool's back, on level teardown for one, are dropped here.
+	while (freeActors.Num() > 0) {
+		auto actor = freeActors.Pop(false);
+		if (!IsValid(actor))
+			continue;
+		Activate(actor, location, rotation);
+		numHits++;
+		BLOCK_PHYSICS_COUNT(ActorPoolHits, 1);
+		return actor;
+	}
+	numMisses++;
+	BLOCK_PHYSICS_COUNT(ActorPoolMisses, 1);
+	return nullptr;
+}
+
+void BlockActorPool::Release(int kind, AActor* actor)
+{
+	if (!IsValid(actor))
+		return;
+	Deactivate(actor);
+	freeActorsPerKind[kind].Add(actor);
+}
+
+void BlockActorPool::DestroyFreeActors()
+{
+	for (auto& freeActors : freeActorsPerKind) {
+		for (auto actor : freeActors) {
+			if (IsValid(actor)) {
+				actor->Destroy();
+				BLOCK_PHYSICS_COUNT(ActorsDestroyed, 1);
+			}
+		}
+		freeActors.Reset();
+	}
+}
+
+float BlockActorPool::GetHitRate() const
+{
+	const auto numAcquired = numHits + numMisses;
+	return numAcquired == 0 ? 1.f : static_cast<float>(numHits) / numAcquired;
+}
+
+void BlockActorPool::Activate(AActor* actor, const FVector& location, const FRotator& rotation)
+{
+	actor->SetActorLocationAndRotation(location, rotation, false, nullptr, ETeleportType::TeleportPhysics);
+	actor->SetActorHiddenInGame(false);
+	actor->SetActorEnableCollision(true);
+	actor->SetActorTickEnabled(true);
+	// Flipbooks, the explosion's for one, start over as if the actor had just been spawned.
+	TInlineComponentArray<UPaperFlipbookComponent*> flipbookComponents(actor);
+	for (auto flipbookComponent : flipbookComponents) {
+		flipbookComponent->PlayFromStart();
+	}
+}
+
+void BlockActorPool::Deactivate(AActor* actor)
+{
+	actor->SetActorHiddenInGame(true);
+	actor->SetActorEnableCollision(false);
+	actor->SetActorTickEnabled(false);
+}
@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BlockDestroySoundAggregator.h"
+#include "BlockPhysics.h"
+
+void BlockDestroySoundAggregator::Gather(const PhysicalBlocksDelta& delta)
+{
+	for (const auto& physicalBlockSnapShot : delta.destroyStarted) {
+		if (physicalBlockSnapShot.block.IsSpecial())
+			numSpecialPops++;
+		else
+			numNormalPops++;
+	}
+}
+
+void BlockDestroySoundAggregator::Flush(int maxVoices, TArray<Voice>& outVoices)
+{
+	outVoices.Reset();
+	auto numVoicesLeft = maxVoices;
+	if (numSpecialPops > 0 && numVoicesLeft > 0) {
+		outVoices.Add(MakeVoice(true, numSpecialPops));
+		numVoicesLeft--;
+	}
+	const auto numNormalVoices = FMath::Min(numVoicesLeft, numNormalPops);
+	for (int i = 0; i < numNormalVoices; i++) {
+		// the first voices take the remainder
+		const auto numPops = numNormalPops / numNormalVoices + (i < numNormalPops % numNormalVoices ? 1 : 0);
+		outVoices.Add(MakeVoice(false, numPops));
+	}
+	numNormalPops = 0;
+	numSpecialPops = 0;
+}
+
+BlockDestroySoundAggregator::Voice BlockDestroySoundAggregator::MakeVoice(bool isSpecial, int numPops)
+{
+	const auto numDoublings = FMath::Log2(static_cast<float>(numPops));
+	auto ret = Voice();
+	ret.isSpecial = isSpecial;
+	ret.numPops = numPops;
+	ret.volumeMultiplier = FMath::Min(1.f + VOLUME_STEP_PER_DOUBLING * numDoublings, MAX_VOLUME_MULTIPLIER);
+	ret.pitchMultiplier = FMath::Min(1.f + PITCH_STEP_PER_DOUBLING * numDoublings, MAX_PITCH_MULTIPLIER);
+	return ret;
+}
@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BlockHandle.h"
+
+const BlockHandle BlockHandle::INVALID = BlockHandle();
+
+uint32 GetTypeHash(const BlockHandle& handle)
+{
+	return HashCombine(GetTypeHash(handle.GetIndex()), GetTypeHash(handle.GetGeneration()));
+}
+
+BlockHandle BlockHandleTable::Allocate(int32 denseIndex)
+{
+	auto slotIndex = INDEX_NONE;
+	if (freeSlotIndices.Num() > 0) {
+		slotIndex = freeSlotIndices.Pop(false);
+	}
+	else {
+		slotIndex = slots.Add(Slot());
+	}
+	auto& slot = slots[slotIndex];
+	slot.denseIndex = denseIndex;
+	return BlockHandle(slotIndex, slot.generation);
+}
+
+void BlockHandleTable::Release(BlockHandle handle)
+{
+	if (!IsAlive(handle)) {
+		UE_LOG(LogTemp, Warning, TEXT("Releasing stale block handle (%d, %d)"), handle.GetIndex(), handle.GetGeneration());
+		return;
+	}
+	auto& slot = slots[handle.GetIndex()];
+	slot.generation++;
+	slot.denseIndex = INDEX_NONE;
+	freeSlotIndices.Add(handle.GetIndex());
+}
+
+void BlockHandleTable::SetDenseIndex(BlockHandle handle, int32 denseIndex)
+{
+	if (!IsAlive(handle))
+		return;
+	slots[handle.GetIndex()].denseIndex = denseIndex;
+}
+
+void BlockHandleTable::Save(FArchive& archive) const
+{
+	auto numSlots = slots.Num();
+	archive << numSlots;
+	for (auto slot : slots) {
+		archive << slot.generation << slot.denseIndex;
+	}
+	auto numFreeSlots = freeSlotIndices.Num();
+	archive << numFreeSlots;
+	for (auto freeSlotIndex : freeSlotIndices) {
+		archive << freeSlotIndex;
+	}
+}
+
+void BlockHandleTable::Load(FArchive& archive)
+{
+	auto numSlots = 0;
+	archive << numSlots;
+	if (archive.IsError() || numSlots < 0 || numSlots > archive.TotalSize() - archive.Tell()) {
+		archive.SetError();
+		return;
+	}
+	slots.SetNum(numSlots);
+	for (auto& slot : slots) {
+		archive << slot.generation << slot.denseIndex;
+	}
+	auto numFreeSlots = 0;
+	archive << numFreeSlots;
+	if (archive.IsError() || numFreeSlots < 0 || numFreeSlots > numSlots) {
+		archive.SetError();
+		return;
+	}
+	freeSlotIndices.SetNum(numFreeSlots);
+	for (auto& freeSlotIndex : freeSlotIndices) {
+		archive << freeSlotIndex;
+		if (!slots.IsValidIndex(freeSlotIndex))
+			archive.SetError();
+	}
+}
+
+int32 BlockHandleTable::FindDenseIndex(BlockHandle handle) const
+{
+	if (!slots.IsValidIndex(handle.GetIndex()))
+		return INDEX_NONE;
+	const auto& slot = slots[handle.GetIndex()];
+	return slot.generation == handle.GetGeneration() ? slot.denseIndex : INDEX_NONE;
+}
@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BlockInstancedRenderer.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Components/SceneComponent.h"
+#include "PaperGroupedSpriteComponent.h"
+
+namespace {
+	const FTransform HIDDEN_TRANSFORM = FTransform(FRotator::ZeroRotator, FVector::ZeroVector, FVector::ZeroVector);
+}
+
+bool BlockInstancedRenderer::Initialize(UWorld* world, const TArray<UPaperSprite*>& layerSprites)
+{
+	if (world == nullptr)
+		return false;
+	hostActor = world->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity);
+	if (hostActor == nullptr)
+		return false;
+	auto root = NewObject<USceneComponent>(hostActor, TEXT("InstancedBlocksRoot"));
+	hostActor->SetRootComponent(root);
+	root->RegisterComponent();
+
+	layers.SetNum(layerSprites.Num());
+	for (int layerIndex = 0; layerIndex < layerSprites.Num(); layerIndex++) {
+		auto& layer = layers[layerIndex];
+		layer.sprite = layerSprites[layerIndex];
+		if (layer.sprite == nullptr)
+			continue;
+		layer.component = NewObject<UPaperGroupedSpriteComponent>(hostActor);
+		layer.component->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		layer.component->SetupAttachment(root);
+		layer.component->RegisterComponent();
+		hostActor->AddInstanceComponent(layer.component);
+	}
+	return true;
+}
+
+void BlockInstancedRenderer::Show(BlockHandle handle, Part part, int layerIndex, const FTransform& transform)
+{
+	auto& partInstance = GetPartInstance(handle, part);
+	if (partInstance.layer != layerIndex)
+		Hide(handle, part);
+	auto& layer = layers[layerIndex];
+	if (layer.component == nullptr)
+		return;
+	if (partInstance.instanceIndex != INDEX_NONE) {
+		SetPendingTransform(layer, partInstance.instanceIndex, transform);
+		return;
+	}
+	partInstance.layer = layerIndex;
+	if (layer.freeInstanceIndices.Num() > 0) {
+		partInstance.instanceIndex = layer.freeInstanceIndices.Pop(false);
+		SetPendingTransform(layer, partInstance.instanceIndex, transform);
+	}
+	else {
+		partInstance.instanceIndex = layer.component->AddInstance(transform, layer.sprite, true);
+	}
+}
+
+void BlockInstancedRenderer::Hide(BlockHandle handle, Part part)
+{
+	auto& partInstance = GetPartInstance(handle, part);
+	if (partInstance.instanceIndex != INDEX_NONE) {
+		auto& layer = layers[partInstance.layer];
+		SetPendingTransform(layer, partInstance.instanceIndex, HIDDEN_TRANSFORM);
+		layer.freeInstanceIndices.Add(partInstance.instanceIndex);
+	}
+	partInstance = PartInstance();
+}
+
+void BlockInstancedRenderer::HideAll(BlockHandle handle)
+{
+	for (int part = 0; part < NUM_PARTS; part++) {
+		Hide(handle, static_cast<Part>(part));
+	}
+}
+
+void BlockInstancedRenderer::Flush()
+{
+	for (auto& layer : layers) {
+		if (layer.pendingInstanceIndices.Num() == 0)
+			continue;
+		for (int i = 0; i < layer.pendingInstanceIndices.Num(); i++) {
+			layer.component->UpdateInstanceTransform(layer.pendingInstanceIndices[i], layer.pendingTransforms[i], true, false, true);
+		}
+		layer.component->MarkRenderStateDirty();
+		layer.pendingInstanceIndices.Reset();
+		layer.pendingTransforms.Reset();
+	}
+}
+
+int BlockInstancedRenderer::GetNumInstances(int layerIndex) const
+{
+	const auto& layer = layers[layerIndex];
+	return layer.component == nullptr ? 0 : layer.component->GetInstanceCount() - layer.freeInstanceIndices.Num();
+}
+
+BlockInstancedRenderer::PartInstance& BlockInstancedRenderer::GetPartInstance(BlockHandle handle, Part part)
+{
+	const auto partIndex = handle.GetIndex() * NUM_PARTS + part;
+	if (partIndex >= partInstances.Num())
+		partInstances.SetNum(partIndex + 1);
+	return partInstances[partIndex];
+}
+
+void BlockInstancedRenderer::SetPendingTransform(Layer& layer, int32 instanceIndex, const FTransform& transform)
+{
+	layer.pendingInstanceIndices.Add(instanceIndex);
+	layer.pendingTransforms.Add(transform);
+}
@@ -1,32 +1,43 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "../Public/BlockMatrix.h"
+#include "Async/ParallelFor.h"
+#include "CoreGlobals.h"
+
+namespace {
+	uint64 MixBits(uint64 value)
+	{
+		value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+		value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+		return value ^ (value >> 31);
+	}
+}
 
 BlockMatrix::BlockMatrix(const TArray<TArray<Block>>& block2DArray)
-	: numRows(block2DArray.Num()), numCols(numRows == 0 ? 0 : block2DArray[0].Num()), block2DArray(block2DArray)
+	: BlockMatrix(block2DArray.Num(), block2DArray.Num() == 0 ? 0 : block2DArray[0].Num())
 {
 	for (int i = 0; i < numRows; i++) {
 		for (int j = 0; j < numCols; j++) {
-			const auto point = FIntPoint{ i, j };
-			blockMatrix.Add(point, block2DArray[i][j]);
+			SetAt(i, j, block2DArray[i][j]);
 		}
 	}
 }
 
-BlockMatrix::BlockMatrix(int numRows, int numCols, const TMap<FIntPoint, Block> blockMatrix)
-	:numRows(numRows), numCols(numCols), blockMatrix(blockMatrix)
+BlockMatrix::BlockMatrix(int numRows, int numCols)
+	:numRows(numRows), numCols(numCols)
+{
+	blocks.Init(Block::INVALID, numRows * numCols);
+}
+
+TArray<TArray<Block>> BlockMatrix::GetBlock2DArray() const
 {
+	auto ret = TArray<TArray<Block>>();
+	ret.Reserve(numRows);
 	for (int i = 0; i < numRows; i++) {
-		block2DArray.Add(TArray<Block>());
-		for (int j = 0; j < numCols; j++) {
-			if (nullptr == blockMatrix.Find(FIntPoint{ i,j })) {
-				block2DArray[i].Add(Block::INVALID);
-			}
-			else {
-				block2DArray[i].Add(*blockMatrix.Find(FIntPoint{ i, j }));
-			}
-		}
+		auto& row = ret.Add_GetRef(TArray<Block>());
+		row.Append(blocks.GetData() + ToIndex(i, 0), numCols);
 	}
+	return ret;
 }
 
 bool BlockMatrix::HasNoMatch() const
@@ -37,21 +48,49 @@ bool BlockMatrix::HasNoMatch() const
 
 Block BlockMatrix::At(int row, int col) const
 {
-	auto pBlock = blockMatrix.Find(FIntPoint{ row, col });
-	return pBlock == nullptr ? Block::INVALID : *pBlock;
+	if (IsOutOfMatrix(FIntPoint{ row, col }))
+		return Block::INVALID;
+	return blocks[ToIndex(row, col)];
+}
+
+void BlockMatrix::SetAt(int row, int col, Block block)
+{
+	if (row < 0 || row >= numRows || col < 0 || col >= numCols)
+		return;
+	auto& cell = blocks[ToIndex(row, col)];
+	hash ^= GetZobristKey(row, col, cell) ^ GetZobristKey(row, col, block);
+	cell = block;
+}
+
+uint64 BlockMatrix::GetZobristKey(int row, int col, Block block)
+{
+	// Empty cells hash to nothing. Keys are mixed from the cell and the block instead of looked up in a table,
+	// which would take 1MB for a 50x50 board.
+	if (block == Block::INVALID)
+		return 0;
+	const auto cellAndBlock = (static_cast<uint64>(row) << 40) | (static_cast<uint64>(col) << 16) | block.Pack();
+	return MixBits(cellAndBlock + 0x9E3779B97F4A7C15ull);
 }
 
 MatchResult BlockMatrix::ProcessMatch(const TSet<FIntPoint>& specialBlockSpawnCandidatePositions)
+{
+	return ProcessMatch(GetMatches(), specialBlockSpawnCandidatePositions);
+}
+
+MatchResult BlockMatrix::ProcessMatch(const TSet<Match>& matches, const TSet<FIntPoint>& specialBlockSpawnCandidatePositions)
 {
 	auto matchResult = MatchResult();
-	const auto matches = GetMatches();
 	for (const auto& match : matches) {
 		const auto matchedLocation = match.GetLocation();
 		const auto matchedFormation = match.GetFormation();
 		const auto matchedPositions = match.GetMatchedPositions();
 		const auto matchedColor = match.GetMatchedColor();
 		const auto specialBlockColor = HasColor(matchedFormation.GetBlockSpecialAttribute()) ? matchedColor : BlockColor::NONE;
-		RemoveBlocksAt(matchedPositions);
+		// Crossing matches share cells; the first one to claim a cell removes it.
+		for (const auto& matchedPosition : matchedPositions) {
+			if (!matchResult.HasMatchedPosition(matchedPosition))
+				RemoveBlockAt(matchedPosition);
+		}
 		matchResult.AddMatchedPositions(matchedPositions);
 		if (matchedFormation.NeedSpecialBlockSpawn())
 			matchResult.AddSpecialBlockWith(
@@ -63,39 +102,71 @@ MatchResult BlockMatrix::ProcessMatch(const TSet<FIntPoint>& specialBlockSpawnCa
 	return matchResult;
 }
 
-void BlockMatrix::RemoveBlocksAt(const TSet<FIntPoint>& positions)
+void BlockMatrix::RemoveBlockAt(FIntPoint position)
 {
-	for (const auto& position : positions) {
-		auto removedNum = blockMatrix.Remove(position);
-		if (removedNum != 1) {
-			UE_LOG(LogTemp, Error, TEXT("removed block does not exist or duplicated in block map: position (%d, %d)"), position.X, position.Y);
-		}
+	if (IsOutOfMatrix(position)) {
+		UE_LOG(LogTemp, Error, TEXT("removed block does not exist or duplicated in block map: position (%d, %d)"), position.X, position.Y);
+		return;
 	}
+	SetAt(position.X, position.Y, Block::INVALID);
 }
 
 bool BlockMatrix::IsOutOfMatrix(FIntPoint point) const
 {
 	return (GetRow(point) < 0) || (GetRow(point) >= numRows) ||
 		(GetCol(point) < 0) || (GetCol(point) >= numCols) ||
-		(block2DArray[point.X][point.Y] == Block::INVALID);
+		(blocks[ToIndex(point.X, point.Y)] == Block::INVALID);
 }
 
-TSet<Match> BlockMatrix::GetMatches() const
+TSet<Match> BlockMatrix::GetMatches(bool allowParallelScan) const
 {
 	auto ret = TSet<Match>();
+	if (!allowParallelScan || (numRows * numCols < PARALLEL_SCAN_MIN_CELLS)) {
+		for (int i = 0; i < numRows; i++) {
+			for (int j = 0; j < numCols; j++) {
+				const auto point = FIntPoint{ i, j };
+				const auto matchAtHereInArray = FindAMatchAt(point);
+				if (matchAtHereInArray.Num() == 0)
+					continue;
+				const auto matchAtHere = matchAtHereInArray.Last();
+				AddAndRemoveSubcompatibles(ret, matchAtHere);
+			}
+		}
+		return ret;
+	}
 
-	for (int i = 0; i < numRows; i++) {
+	// Finding the match anchored at each cell only reads the matrix, so bands of rows are scanned independently.
+	// The bands split the anchor rows without overlapping; a formation anchored in a band may read rows of the bands
+	// below it, which is safe since nothing writes to them.
+	// Merging depends on the order matches are found in, so the matches of the bands are merged serially
+	// in row-major order, exactly as the serial scan does.
+	// Off the game thread, as in the bot's parallel rollouts, the workers are already busy, so the bands are scanned in turn.
+	auto matchesPerBand = TArray<TArray<Match>>();
+	const auto numBands = (numRows + ROWS_PER_SCAN_BAND - 1) / ROWS_PER_SCAN_BAND;
+	matchesPerBand.SetNum(numBands);
+	ParallelFor(numBands, [&](int32 bandIndex) {
+		const auto beginRow = bandIndex * ROWS_PER_SCAN_BAND;
+		FindMatchesAnchoredInRows(beginRow, FMath::Min(beginRow + ROWS_PER_SCAN_BAND, numRows), matchesPerBand[bandIndex]);
+	}, !IsInGameThread());
+
+	for (const auto& bandMatches : matchesPerBand) {
+		for (const auto& match : bandMatches) {
+			AddAndRemoveSubcompatibles(ret, match);
+		}
+	}
+	return ret;
+}
+
+void BlockMatrix::FindMatchesAnchoredInRows(int beginRow, int endRow, TArray<Match>& outMatches) const
+{
+	for (int i = beginRow; i < endRow; i++) {
 		for (int j = 0; j < numCols; j++) {
-			const auto point = FIntPoint{ i, j };
-			const auto matchAtHereInArray = FindAMatchAt(point);
+			const auto matchAtHereInArray = FindAMatchAt(FIntPoint{ i, j });
 			if (matchAtHereInArray.Num() == 0)
 				continue;
-			const auto matchAtHere = matchAtHereInArray.Last();
-			AddAndRemoveSubcompatibles(ret, matchAtHere);
+			outMatches.Add(matchAtHereInArray.Last());
 		}
 	}
-
-	return ret;
 }
 
 TArray<Match> BlockMatrix::FindAMatchAt(FIntPoint point) const
@@ -127,16 +198,19 @@ bool BlockMatrix::IsFormationOutOfMatrix(const Formation& formation, FIntPoint p
 
 bool BlockMatrix::ColorOfBlocksConsistentIn(const Formation& formation, FIntPoint point) const
 {
-	auto colors = TSet<BlockColor>();
+	if (formation.vectors.Num() == 0)
+		return false;
+	const auto firstColor = At(point.X + formation.vectors[0].X, point.Y + formation.vectors[0].Y).GetColor();
 	for (const auto& vector : formation.vectors) {
-		if (!blockMatrix.Contains(point + vector)) {
+		const auto block = At(point.X + vector.X, point.Y + vector.Y);
+		if (block == Block::INVALID) {
 			UE_LOG(LogTemp, Warning, TEXT("IsOutOfMatrix ߴµ blockMatrix  "));
-			colors.Empty();
-			break;
+			return false;
 		}
-		colors.Add(blockMatrix.FindRef(point + vector).GetColor());
+		if (block.GetColor() != firstColor)
+			return false;
 	}
-	return (colors.Num() == 1);
+	return true;
 }
 
 void MatchResult::AddMatchedPositions(const TSet<FIntPoint>& matchedPositions)
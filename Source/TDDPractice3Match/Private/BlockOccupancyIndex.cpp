@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BlockOccupancyIndex.h"
+
+void BlockOccupancyIndex::Reset(int newNumRows, int newNumCols)
+{
+	numRows = newNumRows;
+	numCols = newNumCols;
+	cellHeads.Init(INDEX_NONE, 2 * numRows * numCols);
+	entries.Reset();
+}
+
+void BlockOccupancyIndex::Add(int32 blockIndex, FVector2D position)
+{
+	const auto minCell = ToCell(position - FVector2D(BLOCK_HALF_EXTENT, BLOCK_HALF_EXTENT));
+	const auto maxCell = ToCell(position + FVector2D(BLOCK_HALF_EXTENT, BLOCK_HALF_EXTENT));
+	for (int row = minCell.X; row <= maxCell.X; row++) {
+		for (int col = minCell.Y; col <= maxCell.Y; col++) {
+			const auto cell = FIntPoint{ row, col };
+			if (!IsIndexed(cell))
+				continue;
+			auto& head = cellHeads[ToCellIndex(cell)];
+			head = entries.Add(Entry{ blockIndex, head });
+		}
+	}
+}
@@ -2,53 +2,117 @@
 
 #include "../Public/BlockPhysics.h"
 #include "GenericPlatform/GenericPlatformMath.h"
+#include "../Public/BlockPhysicsTraceDecoder.h"
+#include "../Public/BlockPhysicsStats.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
 
 BlockPhysics::BlockPhysics(const BlockMatrix& blockMatrix, TFunction<int(void)> newBlockGenerator, TFunction<int(void)> randomDirectionGenerator)
-	:newBlockGenerator(newBlockGenerator), randomDirectionGenerator(randomDirectionGenerator)
+	:BlockPhysics(blockMatrix)
+{
+	this->newBlockGenerator = newBlockGenerator;
+	this->randomDirectionGenerator = randomDirectionGenerator;
+}
+
+BlockPhysics::BlockPhysics(const BlockMatrix& blockMatrix, uint64 randomSeed)
+	:randomGenerator(randomSeed)
 {
 	const auto block2DArray = blockMatrix.GetBlock2DArray();
 	numRows = block2DArray.Num();
 	numCols = numRows == 0 ? 0 : block2DArray[0].Num();
+	logicalGrid = BlockMatrix(numRows, numCols);
+	logicalGridOwners.Init(BlockHandle::INVALID, numRows * numCols);
+	blockHandlesPerColor.SetNum(validColors.Num());
 	for (int i = 0; i < numRows; i++) {
 		for (int j = 0; j < numCols; j++) {
-			physicalBlocks.Add(PhysicalBlock(block2DArray[i][j], FIntPoint{ i, j }));
+			SpawnPhysicalBlock(block2DArray[i][j], FIntPoint{ i, j });
 		}
 	}
+#if BLOCK_PHYSICS_TRACE_ENABLED
+	trace = MakeUnique<BlockPhysicsTrace>();
+#endif
+	PublishSnapShots();
 }
 
 BlockPhysics::BlockPhysics(BlockPhysics&& other)
-	:physicalBlocks(MoveTemp(other.physicalBlocks)), numRows(other.numRows), numCols(other.numCols)
+	:physicalBlocks(MoveTemp(other.physicalBlocks)), handleTable(MoveTemp(other.handleTable)), numRows(other.numRows), numCols(other.numCols),
+	logicalGrid(MoveTemp(other.logicalGrid)), logicalGridOwners(MoveTemp(other.logicalGridOwners)), blockHandlesPerColor(MoveTemp(other.blockHandlesPerColor)), elapsedTime(other.elapsedTime),
+	randomGenerator(other.randomGenerator), newBlockGenerator(MoveTemp(other.newBlockGenerator)), randomDirectionGenerator(MoveTemp(other.randomDirectionGenerator)),
+	matchCache(MoveTemp(other.matchCache))
 {
+#if BLOCK_PHYSICS_TRACE_ENABLED
+	trace = MoveTemp(other.trace);
+#endif
+	PublishSnapShots();
+}
 
+BlockPhysics::BlockPhysics(const BlockPhysics& other, CloneTag)
+	:enableTickDebugLog(other.enableTickDebugLog), matchesOccuredInThisTick(other.matchesOccuredInThisTick), numDestroyedBlocksInThisTick(other.numDestroyedBlocksInThisTick),
+	handleTable(other.handleTable), numRows(other.numRows), numCols(other.numCols),
+	logicalGrid(other.logicalGrid), logicalGridOwners(other.logicalGridOwners), blockHandlesPerColor(other.blockHandlesPerColor), elapsedTime(other.elapsedTime), randomGenerator(other.randomGenerator),
+	publishedBufferIndex(other.publishedBufferIndex), lastPublishedSnapShotPerSlot(other.lastPublishedSnapShotPerSlot), publishedDelta(other.publishedDelta),
+	newBlockGenerator(other.newBlockGenerator), randomDirectionGenerator(other.randomDirectionGenerator), matchCache(other.matchCache)
+{
+	physicalBlocks.Reserve(other.physicalBlocks.Num());
+	for (const auto& physicalBlock : other.physicalBlocks) {
+		physicalBlocks.Add(physicalBlock.Clone(*this));
+	}
+	publishedSnapShots[0] = other.publishedSnapShots[0];
+	publishedSnapShots[1] = other.publishedSnapShots[1];
 }
 
 BlockPhysics::~BlockPhysics()
 {
 }
 
+BlockPhysics BlockPhysics::Clone() const
+{
+	return BlockPhysics(*this, CloneTag());
+}
+
 void BlockPhysics::Tick(float deltaSeconds)
 {
+	BLOCK_PHYSICS_SCOPED_STAT(Tick);
 	elapsedTime += deltaSeconds;
-	matchesOccuredInThisTick.Empty();
-	blockIdsThatShouldNotTick.Empty();
-	if(enableTickDebugLog)
-		UE_LOG(LogTemp, Display, TEXT("Tick start. Elapsed time: %f"), elapsedTime);
-	const auto snapshotsBeforeTick = GetPhysicalBlockSnapShots();
-	TickBlockActions(deltaSeconds);
+	matchesOccuredInThisTick.Reset();
+	comboConsumedBlockHandles.Reset();
+	BLOCK_PHYSICS_TRACE(*this, TickStart, nullptr, FVector2D::ZeroVector);
+	MarkBlocksGettingDestroyedAtTickStart();
+	{
+		BLOCK_PHYSICS_SCOPED_STAT(TickActions);
+		TickBlockActions(deltaSeconds);
+		ResolveRolls();
+	}
 	auto thereIsAMatch = false;
-	if (ShouldCheckMatch()) {
-		thereIsAMatch = CheckAndProcessMatch();
+	{
+		BLOCK_PHYSICS_SCOPED_STAT(CheckMatch);
+		if (ShouldCheckMatch()) {
+			const auto isComboResolved = ResolveSwipedSpecials();
+			thereIsAMatch = CheckAndProcessMatch() || isComboResolved;
+		}
+	}
+	{
+		BLOCK_PHYSICS_SCOPED_STAT(ResolveExplosions);
+		if (!comboMask.IsEmpty()) {
+			DestroyBlocksAndGetTheirHandles(comboMask);
+			comboMask.Reset(numRows, numCols);
+		}
+		RecursivelyApplyExplosionEffects(GetBlockHandlesJustStartedGettingDestroyed());
+		numDestroyedBlocksInThisTick = CountBlocksJustStartedGettingDestroyed();
+	}
+	{
+		BLOCK_PHYSICS_SCOPED_STAT(RemoveDeadBlocks);
+		RemoveDeadBlocks();
+	}
+	{
+		BLOCK_PHYSICS_SCOPED_STAT(ChangeActions);
+		ChangeCompletedActionsToNextActions(thereIsAMatch);
+	}
+	{
+		BLOCK_PHYSICS_SCOPED_STAT(FallAndRefill);
+		SetFallingActionsAndGenerateNewBlocks();
 	}
-	const auto snapshotsAfterTick = GetPhysicalBlockSnapShots();
-	const auto snapshotDiff = PhysicalBlocksSnapShotDiff(snapshotsBeforeTick, snapshotsAfterTick);
-	const auto blockIdsDestroyedInThisTick = snapshotDiff.GetJustDestroyedBlockIds();
-	RecursivelyApplyExplosionEffects(blockIdsDestroyedInThisTick);
-	const auto snapshotAfterExplosion = GetPhysicalBlockSnapShots();
-	const auto finalSnapshotDiff = PhysicalBlocksSnapShotDiff(snapshotsBeforeTick, snapshotAfterExplosion);
-	numDestroyedBlocksInThisTick = finalSnapshotDiff.GetJustDestroyedBlockIds().Num();
-	RemoveDeadBlocks();
-	ChangeCompletedActionsToNextActions(thereIsAMatch);
-	SetFallingActionsAndGenerateNewBlocks();
+	PublishSnapShots();
 }
 
 TSet<Match> BlockPhysics::GetMatchesInThisTick() const
@@ -56,23 +120,71 @@ TSet<Match> BlockPhysics::GetMatchesInThisTick() const
 	return matchesOccuredInThisTick;
 }
 
+int BlockPhysics::GetScoreInThisTick() const
+{
+	auto ret = numDestroyedBlocksInThisTick * SCORE_PER_DESTROYED_BLOCK;
+	for (const auto& match : matchesOccuredInThisTick) {
+		ret += match.GetFormation().GetScore();
+	}
+	return ret;
+}
+
 void BlockPhysics::TickBlockActions(float deltaSeconds)
 {
+	auto numBlocksTicked = 0;
 	for (auto& block : physicalBlocks) {
-		if (blockIdsThatShouldNotTick.Contains(block.GetId()))
-			continue;
-
+		// idle blocks stay put, so a settled board keeps its index
+		if (block.currentAction->GetType() != ActionType::Idle)
+			isOccupancyIndexStale = true;
 		block.currentAction->Tick(deltaSeconds);
+		numBlocksTicked++;
 		if (block.currentAction->IsJustCompleted()) {
-			UE_LOG(LogTemp, Display, TEXT("action completed. Action type: %s, block type: %s, position: %f, %f"), 
-				*PrettyPrint(block.currentAction->GetType()), 
-				*PrettyPrint(block.block), 
-				block.currentAction->GetPosition().X,
-				block.currentAction->GetPosition().Y);
+			BLOCK_PHYSICS_TRACE(*this, ActionCompleted, &block, block.currentAction->GetPosition());
+			SyncLogicalGrid(block);
+		}
+	}
+	BLOCK_PHYSICS_COUNT(BlocksTicked, numBlocksTicked);
+}
+
+void BlockPhysics::ResolveRolls()
+{
+	auto isOccupancyBuilt = false;
+	for (const auto& rollable : physicalBlocks) {
+		if (rollable.currentAction->GetType() != ActionType::Roll)
+			continue;
+		// Rollables set rolling here haven't ticked yet and sweep nothing until the next tick.
+		const auto sweptSegment = rollable.currentAction->GetSweptSegment().ClipTo(numRows, numCols);
+		if (sweptSegment.numCells == 0)
+			continue;
+		// Rolled over blocks keep their positions, so one index serves every roll of the tick.
+		if (!isOccupancyBuilt) {
+			RebuildOccupancyIndex();
+			isOccupancyBuilt = true;
+		}
+		auto cell = sweptSegment.firstCell;
+		for (int i = 0; i < sweptSegment.numCells; i++, cell += sweptSegment.step) {
+			ApplyRollOverEffectAt(cell, rollable.GetHandle(), sweptSegment.step);
 		}
 	}
 }
 
+const BlockOccupancyIndex& BlockPhysics::GetOccupancyIndex() const
+{
+	if (isOccupancyIndexStale)
+		RebuildOccupancyIndex();
+	return occupancyIndex;
+}
+
+void BlockPhysics::RebuildOccupancyIndex() const
+{
+	occupancyIndex.Reset(numRows, numCols);
+	// Added in reverse so that each cell lists its blocks in physicalBlocks order
+	for (int blockIndex = physicalBlocks.Num() - 1; blockIndex >= 0; blockIndex--) {
+		occupancyIndex.Add(blockIndex, physicalBlocks[blockIndex].currentAction->GetPosition());
+	}
+	isOccupancyIndexStale = false;
+}
+
 bool BlockPhysics::ShouldCheckMatch()
 {
 	for (auto& block : physicalBlocks) {
@@ -82,18 +194,38 @@ bool BlockPhysics::ShouldCheckMatch()
 	return false;
 }
 
+bool BlockPhysics::AreAllBlocksEligibleForMatching() const
+{
+	for (const auto& physicalBlock : physicalBlocks) {
+		if (!physicalBlock.currentAction->IsEligibleForMatching())
+			return false;
+	}
+	return true;
+}
+
 bool BlockPhysics::CheckAndProcessMatch()
 {
-	UE_LOG(LogTemp, Display, TEXT("match check"));
-	auto blockMatrix = GetBlockMatrix();
-	auto thereIsAMatch = !blockMatrix.HasNoMatch();
+	// Only settled boards come back often enough to be worth caching; mid-cascade grids rarely repeat.
+	const auto shouldUseMatchCache = matchCache && AreAllBlocksEligibleForMatching();
+	const auto cachedMatches = shouldUseMatchCache ? matchCache->Find(logicalGrid.GetHash()) : nullptr;
+	if (cachedMatches) {
+		matchesOccuredInThisTick = *cachedMatches;
+	}
+	else {
+		matchesOccuredInThisTick = logicalGrid.GetMatches();
+		if (shouldUseMatchCache)
+			matchCache->Add(logicalGrid.GetHash(), matchesOccuredInThisTick);
+	}
+	auto thereIsAMatch = matchesOccuredInThisTick.Num() > 0;
 	if (thereIsAMatch) {
-		UE_LOG(LogTemp, Display, TEXT("match occured"));
-		matchesOccuredInThisTick = blockMatrix.GetMatches();
-		auto matchResult = blockMatrix.ProcessMatch(GetBlockInflowPositions());
+		BLOCK_PHYSICS_COUNT(MatchesFound, matchesOccuredInThisTick.Num());
+		// Matched cells get cleared here already; the actions set below clear them again through SyncLogicalGrid.
+		auto matchResult = logicalGrid.ProcessMatch(matchesOccuredInThisTick, GetBlockInflowPositions());
 		StartDestroyingMatchedBlocksAccordingTo(matchResult);
 		SetSpecialBlocksSpawnAccordingTo(matchResult);
 	}
+	// argument X holds the number of matches found
+	BLOCK_PHYSICS_TRACE(*this, MatchChecked, nullptr, FVector2D::ZeroVector, FVector2D(matchesOccuredInThisTick.Num(), 0));
 	return thereIsAMatch;
 }
 
@@ -108,48 +240,191 @@ TSet<FIntPoint> BlockPhysics::GetBlockInflowPositions()
 	return ret;
 }
 
-void BlockPhysics::RecursivelyApplyExplosionEffects(const TSet<int>& destroyedBlockIds)
+void BlockPhysics::MarkBlocksGettingDestroyedAtTickStart()
 {
-	if (destroyedBlockIds.Num() == 0)
+	for (auto& block : physicalBlocks) {
+		block.wasGettingDestroyedAtTickStart = block.IsGettingDestroyed();
+	}
+}
+
+TSet<BlockHandle> BlockPhysics::GetBlockHandlesJustStartedGettingDestroyed() const
+{
+	auto ret = TSet<BlockHandle>();
+	for (const auto& block : physicalBlocks) {
+		if (block.IsGettingDestroyed() && !block.wasGettingDestroyedAtTickStart)
+			ret.Add(block.GetHandle());
+	}
+	return ret;
+}
+
+int BlockPhysics::CountBlocksJustStartedGettingDestroyed() const
+{
+	auto ret = 0;
+	for (const auto& block : physicalBlocks) {
+		if (block.IsGettingDestroyed() && !block.wasGettingDestroyedAtTickStart)
+			ret++;
+	}
+	return ret;
+}
+
+void BlockPhysics::RecursivelyApplyExplosionEffects(const TSet<BlockHandle>& destroyedBlockHandles)
+{
+	if (destroyedBlockHandles.Num() == 0)
 		return;
 
-	auto newlyDestroyedBlockIds = TSet<int>();
-	for (const auto& physicalBlock : physicalBlocks) {
-		if (destroyedBlockIds.Contains(physicalBlock.GetId())) {
-			const auto explosionArea = physicalBlock.GetExplosionArea(GRID_SIZE);
-			newlyDestroyedBlockIds.Append(DestroyBlocksAndGetTheirIds(*explosionArea));
+	// Every explosion of this wave goes into one mask, then the blocks are tested against it in one pass.
+	explosionMask.Reset(numRows, numCols);
+	for (const auto destroyedBlockHandle : destroyedBlockHandles) {
+		const auto* physicalBlock = FindBlock(destroyedBlockHandle);
+		if (physicalBlock == nullptr || comboConsumedBlockHandles.Contains(destroyedBlockHandle))
+			continue;
+		auto block = physicalBlock->block;
+		// A one color clear set off without a color picked, by another explosion or another one color clear, takes the most common color.
+		if (block.GetSpecialAttribute() == BlockSpecialAttribute::ONE_COLOR_CLEAR && GetColorIndex(block.GetColor()) == INDEX_NONE)
+			block = Block(GetMostCommonColorNotIn(explosionMask), BlockSpecialAttribute::ONE_COLOR_CLEAR);
+		block.AddExplosionTo(explosionMask, ToFIntPoint(physicalBlock->currentAction->GetPosition()));
+	}
+	if (explosionMask.IsEmpty())
+		return;
+	RecursivelyApplyExplosionEffects(DestroyBlocksAndGetTheirHandles(explosionMask));
+}
+
+TSet<BlockHandle> BlockPhysics::DestroyBlocksAndGetTheirHandles(const ExplosionMask& explosionMask)
+{
+	auto ret = TSet<BlockHandle>();
+	// Lines and stencil cells hit every block whose rounded position they cover, falling, swiped and rolling ones included.
+	if (explosionMask.ContainsAnyLine()) {
+		for (auto& physicalBlock : physicalBlocks) {
+			const auto blockPosition = physicalBlock.currentAction->GetPosition();
+			if ((physicalBlock.currentAction->GetType() != ActionType::GetsDestroyed) &&
+				explosionMask.Contains(ToFIntPoint(blockPosition))) {
+				ret.Add(physicalBlock.GetHandle());
+				SetAction(physicalBlock, MakeUnique<GetsDestroyedBlockAction>(blockPosition));
+			}
+		}
+	}
+	else if (explosionMask.GetCells().Num() > 0) {
+		// Blocks getting destroyed keep their positions, so the index stays valid throughout.
+		const auto& index = GetOccupancyIndex();
+		for (const auto cell : explosionMask.GetCells()) {
+			index.ForEachBlockIn(cell, [&](int32 blockIndex) {
+				auto& physicalBlock = physicalBlocks[blockIndex];
+				const auto blockPosition = physicalBlock.currentAction->GetPosition();
+				// the index also lists the blocks merely overlapping the cell
+				if ((physicalBlock.currentAction->GetType() != ActionType::GetsDestroyed) &&
+					ToFIntPoint(blockPosition) == cell) {
+					ret.Add(physicalBlock.GetHandle());
+					SetAction(physicalBlock, MakeUnique<GetsDestroyedBlockAction>(blockPosition));
+				}
+			});
 		}
 	}
-	RecursivelyApplyExplosionEffects(newlyDestroyedBlockIds);
+	for (int colorIndex = 0; colorIndex < validColors.Num(); colorIndex++) {
+		if (!explosionMask.ContainsColor(validColors[colorIndex]))
+			continue;
+		for (const auto handle : blockHandlesPerColor[colorIndex]) {
+			auto* physicalBlock = FindBlock(handle);
+			if (physicalBlock == nullptr || physicalBlock->currentAction->GetType() == ActionType::GetsDestroyed)
+				continue;
+			ret.Add(handle);
+			SetAction(*physicalBlock, MakeUnique<GetsDestroyedBlockAction>(physicalBlock->currentAction->GetPosition()));
+		}
+	}
+	return ret;
 }
 
-TSet<int> BlockPhysics::DestroyBlocksAndGetTheirIds(const ExplosionArea& explosionArea)
+BlockColor BlockPhysics::GetMostCommonColorNotIn(const ExplosionMask& explosionMask) const
 {
-	auto ret = TSet<int>();
-	for (auto& physicalBlock : physicalBlocks) {
-		const auto blockPosition = physicalBlock.currentAction->GetPosition();
-		if ((explosionArea.Contains(blockPosition)) &&
-			(physicalBlock.currentAction->GetType() != ActionType::GetsDestroyed)) {
-			ret.Add(physicalBlock.GetId());
-			physicalBlock.currentAction = MakeUnique<GetsDestroyedBlockAction>(blockPosition);
+	auto ret = BlockColor::NONE;
+	auto maxNumBlocks = 0;
+	for (int colorIndex = 0; colorIndex < validColors.Num(); colorIndex++) {
+		const auto numBlocks = blockHandlesPerColor[colorIndex].Num();
+		if (numBlocks > maxNumBlocks && !explosionMask.ContainsColor(validColors[colorIndex])) {
+			ret = validColors[colorIndex];
+			maxNumBlocks = numBlocks;
 		}
 	}
 	return ret;
 }
 
+bool BlockPhysics::ResolveSwipedSpecials()
+{
+	auto isResolved = false;
+	for (auto& physicalBlock : physicalBlocks) {
+		if (!IsJustSwiped(physicalBlock) || !physicalBlock.block.IsSpecial())
+			continue;
+		auto* partner = FindSwipePartner(physicalBlock);
+		if (partner == nullptr)
+			continue;
+		const auto& combo = SpecialCombo::Find(physicalBlock.block.GetSpecialAttribute(), partner->block.GetSpecialAttribute());
+		if (combo.GetType() == SpecialComboType::None)
+			continue;
+		isResolved = true;
+		if (!combo.HasCellEffect()) {
+			// One color clears go off on their own; the block swiped with them goes down with its color.
+			for (auto* swipedBlock : { &physicalBlock, partner }) {
+				if (swipedBlock->block.GetSpecialAttribute() == BlockSpecialAttribute::ONE_COLOR_CLEAR)
+					SetAction(*swipedBlock, MakeUnique<GetsDestroyedBlockAction>(swipedBlock->currentAction->GetPosition()));
+			}
+			continue;
+		}
+		if (comboMask.GetNumRows() != numRows || comboMask.GetNumCols() != numCols)
+			comboMask.Reset(numRows, numCols);
+		combo.AddEffectTo(comboMask, ToFIntPoint(physicalBlock.currentAction->GetPosition()), ToFIntPoint(partner->currentAction->GetPosition()));
+		for (auto* swipedBlock : { &physicalBlock, partner }) {
+			comboConsumedBlockHandles.Add(swipedBlock->GetHandle());
+			SetAction(*swipedBlock, MakeUnique<GetsDestroyedBlockAction>(swipedBlock->currentAction->GetPosition()));
+		}
+	}
+	return isResolved;
+}
+
+bool BlockPhysics::IsJustSwiped(const PhysicalBlock& physicalBlock)
+{
+	return (physicalBlock.currentAction->GetType() == ActionType::SwipeMove) && physicalBlock.currentAction->IsJustCompleted();
+}
+
+PhysicalBlock* BlockPhysics::FindSwipePartner(const PhysicalBlock& swipedBlock)
+{
+	// The two blocks of a swap end up where the other one started.
+	const auto cell = ToFIntPoint(swipedBlock.currentAction->GetPosition());
+	const auto startCell = ToFIntPoint(swipedBlock.currentAction->GetOccupiedPosition());
+	for (auto& physicalBlock : physicalBlocks) {
+		if (&physicalBlock == &swipedBlock || !IsJustSwiped(physicalBlock))
+			continue;
+		if (ToFIntPoint(physicalBlock.currentAction->GetPosition()) == startCell && ToFIntPoint(physicalBlock.currentAction->GetOccupiedPosition()) == cell)
+			return &physicalBlock;
+	}
+	return nullptr;
+}
+
 void BlockPhysics::RemoveDeadBlocks()
 {
-	physicalBlocks.RemoveAll([](const PhysicalBlock& target) -> bool {
-		return target.currentAction->ShouldBeRemoved();
-		});
+	auto numAliveBlocks = 0;
+	for (int i = 0; i < physicalBlocks.Num(); i++) {
+		if (physicalBlocks[i].currentAction->ShouldBeRemoved()) {
+			ClearLogicalGridCell(physicalBlocks[i]);
+			RemoveFromColorIndex(physicalBlocks[i]);
+			handleTable.Release(physicalBlocks[i].GetHandle());
+			continue;
+		}
+		if (numAliveBlocks != i) {
+			physicalBlocks[numAliveBlocks] = MoveTemp(physicalBlocks[i]);
+			handleTable.SetDenseIndex(physicalBlocks[numAliveBlocks].GetHandle(), numAliveBlocks);
+		}
+		numAliveBlocks++;
+	}
+	if (numAliveBlocks < physicalBlocks.Num())
+		physicalBlocks.RemoveAt(numAliveBlocks, physicalBlocks.Num() - numAliveBlocks, false);
+	isOccupancyIndexStale = true;
 }
 
 void BlockPhysics::ChangeCompletedActionsToNextActions(bool thereIsAMatch)
 {
 	for (auto& physicalBlock : physicalBlocks) {
 		if (physicalBlock.currentAction->IsJustCompleted()) {
-			physicalBlock.block = physicalBlock.currentAction->GetNextBlock(physicalBlock.block);
-			physicalBlock.currentAction = physicalBlock.currentAction->GetNextAction(thereIsAMatch);
+			SetBlock(physicalBlock, physicalBlock.currentAction->GetNextBlock(physicalBlock.block));
+			SetAction(physicalBlock, physicalBlock.currentAction->GetNextAction(thereIsAMatch));
 		}
 	}
 }
@@ -158,7 +433,8 @@ void BlockPhysics::SetFallingActionsAndGenerateNewBlocks()
 {
 	class BlocksInColumn {
 	public:
-		BlocksInColumn(BlockPhysics& blockPhysics, int col) : col(col) {
+		BlocksInColumn(BlockPhysics& blockPhysics, int col) : blocksInCol(blockPhysics.blocksInColumn), col(col) {
+			blocksInCol.Reset();
 			for (auto& block : blockPhysics.physicalBlocks) {
 				const auto isOccupyingPositionInThisColumn = FGenericPlatformMath::Abs(block.currentAction->GetOccupiedPosition().Y - col) < blockPhysics.DELTA_DISTANCE;
 				if (isOccupyingPositionInThisColumn) {
@@ -174,11 +450,11 @@ void BlockPhysics::SetFallingActionsAndGenerateNewBlocks()
 		PhysicalBlock& PopLowest() {
 			auto* physicalBlock = blocksInCol.Pop();
 			if (physicalBlock == nullptr)
-				UE_LOG(LogTemp, Error, TEXT("Queryed GetTopmostBlockAt with non-empty location and got nullptr"));
+				UE_LOG(LogBlockPhysics, Error, TEXT("Queryed GetTopmostBlockAt with non-empty location and got nullptr"));
 			return *physicalBlock;
 		}
 	private:
-		TArray<PhysicalBlock*> blocksInCol;
+		TArray<PhysicalBlock*>& blocksInCol;
 		int col;
 	};
 
@@ -203,19 +479,20 @@ void BlockPhysics::SetFallingActionsAndGenerateNewBlocks()
 	for (int col = 0; col < numCols; col++) {
 		auto blocksInCol = BlocksInColumn(*this, col);
 		if (blocksInCol.NumOccupiedCellsInColumn() == numRows) {
-			if (enableTickDebugLog)
-				UE_LOG(LogTemp, Display, TEXT("Column %d has all cells occupied"), col);
+			BLOCK_PHYSICS_TRACE(*this, ColumnFull, nullptr, FVector2D(0, col));
 			continue;
 		}
 		auto positionsInCol = PositionsInColumn(col, numRows-1);
 		auto topRow = -1;
 		while (!positionsInCol.IsEmpty()) {
 			if (blocksInCol.IsEmpty()) {
-				auto destination = positionsInCol.PopLowest();
-				UE_LOG(LogTemp, Display, TEXT("New physicalBlock generated at: (%d, %d)"), topRow, col);
-				auto newBlock = PhysicalBlock(GetRandomBlock(), FIntPoint{ topRow--, col });
-				MakeBlockFallToDestination(newBlock, destination);
-				physicalBlocks.Add(MoveTemp(newBlock));
+				GenerateRefillColorIndices(positionsInCol.lowestRow + 1);
+				for (const auto colorIndex : refillColorIndices) {
+					auto destination = positionsInCol.PopLowest();
+					auto& newBlock = SpawnPhysicalBlock(Block(validColors[colorIndex], BlockSpecialAttribute::NONE), FIntPoint{ topRow--, col });
+					BLOCK_PHYSICS_TRACE(*this, BlockGenerated, &newBlock, newBlock.currentAction->GetPosition());
+					MakeBlockFallToDestination(newBlock, destination);
+				}
 			}
 			else {
 				auto& currentBlock = blocksInCol.PopLowest();
@@ -238,24 +515,29 @@ void BlockPhysics::ReceiveSwipeInput(FIntPoint swipeStart, FIntPoint swipeEnd)
 {
 	auto startBlock = GetTopmostBlockAt(swipeStart);
 	if (startBlock == nullptr) {
-		UE_LOG(LogTemp, Warning, TEXT("ReceiveSwipeInput precondition: block should exist at start position: (%d, %d)"),
+		UE_LOG(LogBlockPhysics, Warning, TEXT("ReceiveSwipeInput precondition: block should exist at start position: (%d, %d)"),
 			swipeStart.X, swipeStart.Y);
 		return;
 	}
 
-	if (startBlock->block != Block::MUNCHICKEN) {
-		auto endBlock = GetTopmostBlockAt(swipeEnd);
+	auto endBlock = GetTopmostBlockAt(swipeEnd);
+	// A munchicken swiped into a block it makes a combo with swaps with it instead of rolling.
+	const auto isCombo = (endBlock != nullptr) &&
+		(SpecialCombo::Find(startBlock->block.GetSpecialAttribute(), endBlock->block.GetSpecialAttribute()).GetType() != SpecialComboType::None);
+	if (startBlock->block != Block::MUNCHICKEN || isCombo) {
 		if (endBlock == nullptr) {
-			UE_LOG(LogTemp, Warning, TEXT("ReceiveSwipeInput precondition: block should exist at end position if swiping block is not munchicken: (%d, %d)"),
+			UE_LOG(LogBlockPhysics, Warning, TEXT("ReceiveSwipeInput precondition: block should exist at end position if swiping block is not munchicken: (%d, %d)"),
 				swipeEnd.X, swipeEnd.Y);
 			return;
 		}
-		startBlock->currentAction = MakeUnique<SwipeMoveBlockAction>(swipeStart, swipeEnd);
-		endBlock->currentAction = MakeUnique<SwipeMoveBlockAction>(swipeEnd, swipeStart);
+		TintOneColorClearSwipedWith(*startBlock, *endBlock);
+		TintOneColorClearSwipedWith(*endBlock, *startBlock);
+		SetAction(*startBlock, MakeUnique<SwipeMoveBlockAction>(swipeStart, swipeEnd));
+		SetAction(*endBlock, MakeUnique<SwipeMoveBlockAction>(swipeEnd, swipeStart));
 	}
 	else {
 		FIntPoint rollDirection = swipeEnd - swipeStart;
-		startBlock->currentAction = MakeUnique<MunchickenRollAction>(swipeStart, rollDirection, *this, startBlock->GetId());
+		SetAction(*startBlock, MakeUnique<MunchickenRollAction>(swipeStart, rollDirection, *this, startBlock->GetHandle()));
 	}
 }
 
@@ -266,29 +548,45 @@ bool BlockPhysics::IsEmpty(FIntPoint position) const
 
 bool BlockPhysics::ExistsBlockBetween(FIntPoint startPos, FIntPoint endPos) const
 {
-	for (const auto& block : physicalBlocks) {
-		const auto blockPos = block.currentAction->GetPosition();
-		auto blockPosToStart = FVector2D(startPos) - blockPos;
-		if (blockPosToStart.IsNearlyZero(DELTA_DISTANCE)) {
-			UE_LOG(LogTemp, Display, TEXT("blockPosToStart Nearly zero"));
-			return true;
-		}
-		blockPosToStart.Normalize();
-		auto blockPosToEnd = FVector2D(endPos) - blockPos;
-		if (blockPosToEnd.IsNearlyZero(DELTA_DISTANCE)) {
-			UE_LOG(LogTemp, Display, TEXT("blockPosToEnd Nearly zero. physicalBlock (%f,%f), end (%d,%d)"),
-				blockPos.X, blockPos.Y, endPos.X, endPos.Y);
-			return true;
-		}
-		blockPosToEnd.Normalize();
-		const auto dotProduct = FVector2D::DotProduct(blockPosToStart, blockPosToEnd);
-		if (FGenericPlatformMath::Abs(dotProduct + 1) < DELTA_COSINE) {
-			UE_LOG(LogTemp, Display, TEXT("start:(%d,%d),end:(%d,%d),dot:%f"),
-				startPos.X, startPos.Y, endPos.X, endPos.Y, dotProduct);
-			return true;
-		}
-	}
-	return false;
+	return FindFirstPhysicalBlockOnSegment(FVector2D(startPos), FVector2D(endPos), DELTA_DISTANCE) != nullptr;
+}
+
+PhysicalBlockSnapShot BlockPhysics::FindFirstBlockOnSegment(FVector2D start, FVector2D end) const
+{
+	const auto* physicalBlock = FindFirstPhysicalBlockOnSegment(start, end, BlockOccupancyIndex::BLOCK_HALF_EXTENT);
+	if (physicalBlock == nullptr)
+		return PhysicalBlockSnapShot(BlockHandle::INVALID, Block::INVALID, ActionType::Invalid, start);
+	return physicalBlock->GetSnapShot();
+}
+
+PhysicalBlockSnapShot BlockPhysics::FindFirstBlockOnRay(FVector2D origin, FVector2D direction, float maxDistance) const
+{
+	return FindFirstBlockOnSegment(origin, origin + direction.GetSafeNormal() * maxDistance);
+}
+
+const PhysicalBlock* BlockPhysics::FindFirstPhysicalBlockOnSegment(FVector2D start, FVector2D end, float blockHalfExtent) const
+{
+	const auto& index = GetOccupancyIndex();
+	const PhysicalBlock* ret = nullptr;
+	auto retEntry = MAX_flt;
+	BlockOccupancyIndex::ForEachCellOnSegment(start, end, [&](FIntPoint cell) {
+		// A block is bucketed in every cell its body overlaps, so the segment enters it in a cell already visited
+		// once the segment enters this cell after it.
+		auto cellEntry = 0.f;
+		BlockOccupancyIndex::IntersectSegmentWithSquare(start, end, FVector2D(cell), 0.5f, cellEntry);
+		if (ret != nullptr && retEntry < cellEntry)
+			return false;
+		index.ForEachBlockIn(cell, [&](int32 blockIndex) {
+			const auto& physicalBlock = physicalBlocks[blockIndex];
+			auto entry = 0.f;
+			if (BlockOccupancyIndex::IntersectSegmentWithSquare(start, end, physicalBlock.currentAction->GetPosition(), blockHalfExtent, entry) && entry < retEntry) {
+				ret = &physicalBlock;
+				retEntry = entry;
+			}
+		});
+		return true;
+	});
+	return ret;
 }
 
 bool BlockPhysics::ExistsBlockNear(FIntPoint searchPosition, float threshold) const
@@ -326,58 +624,219 @@ bool BlockPhysics::IsInAction() const
 	return false;
 }
 
-void BlockPhysics::ApplyRollOverEffectAt(const TSet<FIntPoint>& destroyPositions, const TSet<int>& exceptionalBlockIds, FIntPoint rollingDirection)
+void BlockPhysics::ApplyRollOverEffectAt(FIntPoint cell, BlockHandle rollableHandle, FIntPoint rollingDirection)
 {
-	for (const auto& destroyPosition : destroyPositions) {
-		auto blocksAtDestroyPosition = GetBlocksAt(destroyPosition);
-		for (auto physicalBlock : blocksAtDestroyPosition) {
-			if (exceptionalBlockIds.Contains(physicalBlock->GetId()))
-				continue;
-
-			if (physicalBlock->block.GetSpecialAttribute() == BlockSpecialAttribute::ROLLABLE){
-				if (physicalBlock->currentAction->GetType() != ActionType::Idle) {
-					continue;
-				}
+	BLOCK_PHYSICS_TRACE(*this, RolledOver, nullptr, FVector2D(cell), FVector2D(rollingDirection));
+	occupancyIndex.ForEachBlockIn(cell, [&](int32 blockIndex) {
+		auto physicalBlock = &physicalBlocks[blockIndex];
+		// Only the blocks resting on the cell get rolled over
+		if (physicalBlock->GetHandle() == rollableHandle || (physicalBlock->currentAction->GetPosition() - cell).SizeSquared() > DELTA_DISTANCE)
+			return;
 
-				const auto rollDirection = GetRandomOrthogonalDirectionFrom(rollingDirection);
-				physicalBlock->currentAction = MakeUnique<MunchickenRollAction>(destroyPosition, rollDirection, *this, physicalBlock->GetId());
-				blockIdsThatShouldNotTick.Add(physicalBlock->GetId());
-				UE_LOG(LogTemp, Display,
-					TEXT("Automatically rolling block: %s at (%d, %d) to direction (%d, %d)"),
-					*PrettyPrint(physicalBlock->block),
-					destroyPosition.X, destroyPosition.Y,
-					rollDirection.X, rollDirection.Y);
-			}
-			else {
-				physicalBlock->currentAction = MakeUnique<GetsDestroyedInBackgroundBlockAction>(destroyPosition);
-				blockIdsThatShouldNotTick.Add(physicalBlock->GetId());
-				UE_LOG(LogTemp, Display, 
-					TEXT("Destroying block: %s at (%d, %d) in background"), 
-					*PrettyPrint(physicalBlock->block), 
-					destroyPosition.X, destroyPosition.Y);
+		if (physicalBlock->block.GetSpecialAttribute() == BlockSpecialAttribute::ROLLABLE){
+			if (physicalBlock->currentAction->GetType() != ActionType::Idle) {
+				return;
 			}
+
+			const auto rollDirection = GetRandomOrthogonalDirectionFrom(rollingDirection);
+			SetAction(*physicalBlock, MakeUnique<MunchickenRollAction>(cell, rollDirection, *this, physicalBlock->GetHandle()));
+			BLOCK_PHYSICS_TRACE(*this, RollableTriggered, physicalBlock, FVector2D(cell), FVector2D(rollDirection));
 		}
-	}
+		else {
+			SetAction(*physicalBlock, MakeUnique<GetsDestroyedInBackgroundBlockAction>(cell));
+			BLOCK_PHYSICS_TRACE(*this, DestroyedInBackground, physicalBlock, FVector2D(cell));
+		}
+	});
 }
 
 PhysicalBlockSnapShot BlockPhysics::GetTopmostBlockSnapShotAt(FIntPoint position) const
 {
 	const auto topmostBlock = GetTopmostBlockAt(position);
 	if (topmostBlock == nullptr)
-		return PhysicalBlockSnapShot(-1, Block::INVALID, ActionType::Invalid, position);
+		return PhysicalBlockSnapShot(BlockHandle::INVALID, Block::INVALID, ActionType::Invalid, position);
 
 	return topmostBlock->GetSnapShot();
 }
 
+PhysicalBlockSnapShot BlockPhysics::GetBlockSnapShot(BlockHandle handle) const
+{
+	const auto* physicalBlock = FindBlock(handle);
+	if (physicalBlock == nullptr)
+		return PhysicalBlockSnapShot(BlockHandle::INVALID, Block::INVALID, ActionType::Invalid, FVector2D::ZeroVector);
+
+	return physicalBlock->GetSnapShot();
+}
+
 TArray<PhysicalBlockSnapShot> BlockPhysics::GetPhysicalBlockSnapShots() const
 {
 	auto ret = TArray<PhysicalBlockSnapShot>();
+	ret.Reserve(physicalBlocks.Num());
 	for (const auto& block : physicalBlocks) {
 		ret.Add(block.GetSnapShot());
 	}
 	return ret;
 }
 
+void BlockPhysics::PublishSnapShots()
+{
+	// Fill the buffer readers aren't looking at, then flip, so views from the previous tick stay intact.
+	const auto backBufferIndex = 1 - publishedBufferIndex;
+	auto& backBuffer = publishedSnapShots[backBufferIndex];
+	backBuffer.Reset(physicalBlocks.Num());
+	publishedDelta.Reset();
+	while (lastPublishedSnapShotPerSlot.Num() < handleTable.GetNumSlots()) {
+		lastPublishedSnapShotPerSlot.Add(PhysicalBlockSnapShot(BlockHandle::INVALID, Block::INVALID, ActionType::Invalid, FVector2D::ZeroVector));
+	}
+	// A slot reused within the tick holds a newer generation, so its previous block reads as removed here.
+	for (auto& lastSnapShot : lastPublishedSnapShotPerSlot) {
+		if (lastSnapShot.handle.IsValid() && !handleTable.IsAlive(lastSnapShot.handle)) {
+			publishedDelta.removed.Add(lastSnapShot.handle);
+			lastSnapShot.handle = BlockHandle::INVALID;
+		}
+	}
+	for (const auto& block : physicalBlocks) {
+		const auto snapShot = block.GetSnapShot();
+		backBuffer.Add(snapShot);
+		auto& lastSnapShot = lastPublishedSnapShotPerSlot[snapShot.handle.GetIndex()];
+		if (!lastSnapShot.handle.IsValid())
+			publishedDelta.spawned.Add(snapShot);
+		else if (!(lastSnapShot.block == snapShot.block) || lastSnapShot.actionType != snapShot.actionType || lastSnapShot.position != snapShot.position) {
+			publishedDelta.changed.Add(snapShot);
+			if (snapShot.actionType == ActionType::GetsDestroyed && lastSnapShot.actionType != ActionType::GetsDestroyed)
+				publishedDelta.destroyStarted.Add(snapShot);
+		}
+		else
+			continue;
+		lastSnapShot = snapShot;
+	}
+	publishedBufferIndex = backBufferIndex;
+}
+
+void PhysicalBlocksDelta::Reset()
+{
+	spawned.Reset();
+	changed.Reset();
+	removed.Reset();
+	destroyStarted.Reset();
+}
+
+void BlockPhysics::SaveState(TArray<uint8>& outBytes) const
+{
+	outBytes.Reset();
+	FMemoryWriter writer(outBytes);
+	auto magic = STATE_MAGIC;
+	auto version = STATE_VERSION;
+	auto savedNumRows = numRows;
+	auto savedNumCols = numCols;
+	auto savedElapsedTime = elapsedTime;
+	writer << magic << version << savedNumRows << savedNumCols << savedElapsedTime;
+	auto randomState = randomGenerator.GetState();
+	for (auto& word : randomState.words) {
+		writer << word;
+	}
+	handleTable.Save(writer);
+
+	auto numBlocks = physicalBlocks.Num();
+	writer << numBlocks;
+	for (const auto& physicalBlock : physicalBlocks) {
+		auto block = physicalBlock.block;
+		auto handleIndex = physicalBlock.GetHandle().GetIndex();
+		auto handleGeneration = physicalBlock.GetHandle().GetGeneration();
+		auto actionClass = static_cast<uint8>(physicalBlock.currentAction->GetActionClass());
+		writer << block << handleIndex << handleGeneration << actionClass;
+		physicalBlock.currentAction->Serialize(writer);
+	}
+}
+
+bool BlockPhysics::LoadState(const TArray<uint8>& bytes)
+{
+	FMemoryReader reader(bytes);
+	auto magic = 0u;
+	auto version = 0u;
+	reader << magic << version;
+	if (reader.IsError() || magic != STATE_MAGIC || version != STATE_VERSION) {
+		UE_LOG(LogBlockPhysics, Warning, TEXT("LoadState: not a version %u board state"), STATE_VERSION);
+		return false;
+	}
+
+	auto loadedNumRows = 0;
+	auto loadedNumCols = 0;
+	auto loadedElapsedTime = 0.f;
+	reader << loadedNumRows << loadedNumCols << loadedElapsedTime;
+	auto loadedRandomState = BlockRandomGeneratorState();
+	for (auto& word : loadedRandomState.words) {
+		reader << word;
+	}
+	auto loadedHandleTable = BlockHandleTable();
+	loadedHandleTable.Load(reader);
+	auto numBlocks = 0;
+	reader << numBlocks;
+	const auto maxSize = MAX_ROW_COL_SIZE;
+	const auto isSizeValid = (0 <= loadedNumRows) && (loadedNumRows <= maxSize) && (0 <= loadedNumCols) && (loadedNumCols <= maxSize);
+	if (reader.IsError() || !isSizeValid || numBlocks < 0 || numBlocks > reader.TotalSize() - reader.Tell()) {
+		UE_LOG(LogBlockPhysics, Warning, TEXT("LoadState: corrupted board header"));
+		return false;
+	}
+
+	auto loadedBlocks = TArray<PhysicalBlock>();
+	loadedBlocks.Reserve(numBlocks);
+	for (int i = 0; i < numBlocks; i++) {
+		auto block = Block();
+		auto handleIndex = INDEX_NONE;
+		auto handleGeneration = 0;
+		auto actionClass = uint8(0);
+		reader << block << handleIndex << handleGeneration << actionClass;
+		const auto handle = BlockHandle(handleIndex, handleGeneration);
+		auto action = BlockAction::CreateForLoading(static_cast<BlockActionClass>(actionClass), *this, handle);
+		if (reader.IsError() || action == nullptr || loadedHandleTable.FindDenseIndex(handle) != i) {
+			UE_LOG(LogBlockPhysics, Warning, TEXT("LoadState: corrupted block %d"), i);
+			return false;
+		}
+		action->Serialize(reader);
+		loadedBlocks.Emplace(block, handle, MoveTemp(action));
+	}
+	if (reader.IsError()) {
+		UE_LOG(LogBlockPhysics, Warning, TEXT("LoadState: truncated board state"));
+		return false;
+	}
+
+	numRows = loadedNumRows;
+	numCols = loadedNumCols;
+	elapsedTime = loadedElapsedTime;
+	randomGenerator.SetState(loadedRandomState);
+	handleTable = MoveTemp(loadedHandleTable);
+	physicalBlocks = MoveTemp(loadedBlocks);
+	matchesOccuredInThisTick.Reset();
+	numDestroyedBlocksInThisTick = 0;
+	RebuildLogicalGrid();
+	RebuildColorIndex();
+	isOccupancyIndexStale = true;
+	PublishSnapShots();
+	return true;
+}
+
+PhysicalBlock& BlockPhysics::SpawnPhysicalBlock(Block block, FIntPoint initialPosition)
+{
+	const auto handle = handleTable.Allocate(physicalBlocks.Num());
+	const auto index = physicalBlocks.Emplace(block, initialPosition, handle);
+	SyncLogicalGrid(physicalBlocks[index]);
+	AddToColorIndex(physicalBlocks[index]);
+	isOccupancyIndexStale = true;
+	return physicalBlocks[index];
+}
+
+const PhysicalBlock* BlockPhysics::FindBlock(BlockHandle handle) const
+{
+	const auto index = handleTable.FindDenseIndex(handle);
+	return index == INDEX_NONE ? nullptr : &physicalBlocks[index];
+}
+
+PhysicalBlock* BlockPhysics::FindBlock(BlockHandle handle)
+{
+	const auto index = handleTable.FindDenseIndex(handle);
+	return index == INDEX_NONE ? nullptr : &physicalBlocks[index];
+}
+
 PhysicalBlock* BlockPhysics::GetTopmostBlockAt(FIntPoint position)
 {
 	auto highestLayerSoFar = INT_MIN;
@@ -408,27 +867,102 @@ const PhysicalBlock* BlockPhysics::GetTopmostBlockAt(FIntPoint position) const
 	return ret;
 }
 
-TArray<PhysicalBlock*> BlockPhysics::GetBlocksAt(FIntPoint position)
+void BlockPhysics::SetAction(PhysicalBlock& physicalBlock, TUniquePtr<BlockAction>&& action)
 {
-	auto ret = TArray<PhysicalBlock*>();
-	for (auto& block : physicalBlocks) {
-		if ((block.currentAction->GetPosition() - position).SizeSquared() <= DELTA_DISTANCE) {
-			ret.Add(&block);
-		}
+	physicalBlock.currentAction = MoveTemp(action);
+	SyncLogicalGrid(physicalBlock);
+	isOccupancyIndexStale = true;
+}
+
+void BlockPhysics::SyncLogicalGrid(PhysicalBlock& physicalBlock)
+{
+	auto newGridIndex = INDEX_NONE;
+	if (physicalBlock.currentAction.IsValid() && physicalBlock.currentAction->IsEligibleForMatching()) {
+		const auto cell = ToFIntPoint(physicalBlock.currentAction->GetPosition());
+		if (cell.X >= 0 && cell.X < numRows && cell.Y >= 0 && cell.Y < numCols)
+			newGridIndex = cell.X * numCols + cell.Y;
 	}
-	return ret;
+	if (physicalBlock.logicalGridIndex != newGridIndex)
+		ClearLogicalGridCell(physicalBlock);
+	if (newGridIndex != INDEX_NONE) {
+		logicalGrid.SetAt(newGridIndex / numCols, newGridIndex % numCols, physicalBlock.block);
+		logicalGridOwners[newGridIndex] = physicalBlock.GetHandle();
+	}
+	physicalBlock.logicalGridIndex = newGridIndex;
+}
+
+void BlockPhysics::RebuildLogicalGrid()
+{
+	logicalGrid = BlockMatrix(numRows, numCols);
+	logicalGridOwners.Init(BlockHandle::INVALID, numRows * numCols);
+	for (auto& physicalBlock : physicalBlocks) {
+		physicalBlock.logicalGridIndex = INDEX_NONE;
+		SyncLogicalGrid(physicalBlock);
+	}
+}
 
+void BlockPhysics::ClearLogicalGridCell(PhysicalBlock& physicalBlock)
+{
+	const auto gridIndex = physicalBlock.logicalGridIndex;
+	physicalBlock.logicalGridIndex = INDEX_NONE;
+	// Another block may have taken the cell over since; leave it alone then.
+	if (gridIndex == INDEX_NONE || logicalGridOwners[gridIndex] != physicalBlock.GetHandle())
+		return;
+	logicalGrid.SetAt(gridIndex / numCols, gridIndex % numCols, Block::INVALID);
+	logicalGridOwners[gridIndex] = BlockHandle::INVALID;
 }
 
-BlockMatrix BlockPhysics::GetBlockMatrix() const
+void BlockPhysics::SetBlock(PhysicalBlock& physicalBlock, Block block)
 {
-	auto blockMatrix = TMap<FIntPoint, Block>();
+	if (physicalBlock.block == block)
+		return;
+	RemoveFromColorIndex(physicalBlock);
+	physicalBlock.block = block;
+	AddToColorIndex(physicalBlock);
+	SyncLogicalGrid(physicalBlock);
+}
+
+void BlockPhysics::TintOneColorClearSwipedWith(PhysicalBlock& swipedBlock, const PhysicalBlock& otherBlock)
+{
+	// Swiped with a colored block, a one color clear takes its color. Swiped with another colorless block it stays colorless.
+	if (swipedBlock.block.GetSpecialAttribute() != BlockSpecialAttribute::ONE_COLOR_CLEAR)
+		return;
+	if (GetColorIndex(otherBlock.block.GetColor()) != INDEX_NONE)
+		SetBlock(swipedBlock, Block(otherBlock.block.GetColor(), BlockSpecialAttribute::ONE_COLOR_CLEAR));
+}
+
+int BlockPhysics::GetColorIndex(BlockColor color)
+{
+	return validColors.Find(color);
+}
+
+int BlockPhysics::GetNumBlocksOfColor(BlockColor color) const
+{
+	const auto colorIndex = GetColorIndex(color);
+	return colorIndex == INDEX_NONE ? 0 : blockHandlesPerColor[colorIndex].Num();
+}
+
+void BlockPhysics::AddToColorIndex(const PhysicalBlock& physicalBlock)
+{
+	const auto colorIndex = GetColorIndex(physicalBlock.block.GetColor());
+	if (colorIndex != INDEX_NONE)
+		blockHandlesPerColor[colorIndex].Add(physicalBlock.GetHandle());
+}
+
+void BlockPhysics::RemoveFromColorIndex(const PhysicalBlock& physicalBlock)
+{
+	const auto colorIndex = GetColorIndex(physicalBlock.block.GetColor());
+	if (colorIndex != INDEX_NONE)
+		blockHandlesPerColor[colorIndex].Remove(physicalBlock.GetHandle());
+}
+
+void BlockPhysics::RebuildColorIndex()
+{
+	blockHandlesPerColor.Reset();
+	blockHandlesPerColor.SetNum(validColors.Num());
 	for (const auto& physicalBlock : physicalBlocks) {
-		if (physicalBlock.currentAction->IsEligibleForMatching()) {
-			blockMatrix.Add(ToFIntPoint(physicalBlock.currentAction->GetPosition()), physicalBlock.block);
-		}
+		AddToColorIndex(physicalBlock);
 	}
-	return BlockMatrix(numRows, numCols, blockMatrix);
 }
 
 void BlockPhysics::StartDestroyingMatchedBlocksAccordingTo(const MatchResult& matchResult)
@@ -438,11 +972,11 @@ void BlockPhysics::StartDestroyingMatchedBlocksAccordingTo(const MatchResult& ma
 		const auto col = matchedPos.Y;
 		auto* physicalBlock = GetTopmostBlockAt(matchedPos);
 		if (physicalBlock == nullptr) {
-			UE_LOG(LogTemp, Warning, TEXT("physicalBlock to update does not exist at (%d, %d)"), row, col);
+			UE_LOG(LogBlockPhysics, Warning, TEXT("physicalBlock to update does not exist at (%d, %d)"), row, col);
 			continue;
 		}
-		UE_LOG(LogTemp, Display, TEXT("physicalBlock to destroy at (%d, %d)"), row, col);
-		physicalBlock->currentAction = MakeUnique<GetsDestroyedBlockAction>(physicalBlock->currentAction->GetPosition());
+		SetAction(*physicalBlock, MakeUnique<GetsDestroyedBlockAction>(physicalBlock->currentAction->GetPosition()));
+		BLOCK_PHYSICS_TRACE(*this, MatchedBlockDestroyStarted, physicalBlock, FVector2D(matchedPos));
 	}
 }
 
@@ -453,22 +987,19 @@ void BlockPhysics::SetSpecialBlocksSpawnAccordingTo(const MatchResult& matchResu
 		const auto spawnPosition = specialBlockAndItsSpawnPosition.Value;
 		auto* physicalBlock = GetTopmostBlockAt(spawnPosition);
 		if (physicalBlock == nullptr) {
-			UE_LOG(LogTemp, Warning, TEXT("physicalBlock to update does not exist at (%d, %d)"), spawnPosition.X, spawnPosition.Y);
+			UE_LOG(LogBlockPhysics, Warning, TEXT("physicalBlock to update does not exist at (%d, %d)"), spawnPosition.X, spawnPosition.Y);
 			continue;
 		}
-		UE_LOG(LogTemp, Display, TEXT("Special physicalBlock %s generation reserved at (%d, %d)"), *PrettyPrint(specialBlock), spawnPosition.X, spawnPosition.Y);
-		physicalBlock->currentAction = MakeUnique<GetsDestroyedAndSpawnBlockAfterAction>(FVector2D(spawnPosition), specialBlock);
+		SetAction(*physicalBlock, MakeUnique<GetsDestroyedAndSpawnBlockAfterAction>(FVector2D(spawnPosition), specialBlock));
+		BLOCK_PHYSICS_TRACE(*this, SpecialBlockSpawnReserved, physicalBlock, FVector2D(spawnPosition));
 	}
 }
 
 void BlockPhysics::MakeBlockFallToDestination(PhysicalBlock& blockStatus, FIntPoint destination)
 {
-	UE_LOG(LogTemp, Display, TEXT("Start falling block %s at (%f,%f) to (%d,%d)"),
-		*PrettyPrint(blockStatus.block),
-		blockStatus.currentAction->GetPosition().X, blockStatus.currentAction->GetPosition().Y,
-		destination.X, destination.Y);
+	BLOCK_PHYSICS_TRACE(*this, FallStarted, &blockStatus, blockStatus.currentAction->GetPosition(), FVector2D(destination));
 	const auto initialPosition = ToFIntPoint(blockStatus.currentAction->GetPosition());
-	blockStatus.currentAction = MakeUnique<FallingBlockAction>(initialPosition, destination);
+	SetAction(blockStatus, MakeUnique<FallingBlockAction>(initialPosition, destination));
 }
 
 FIntPoint BlockPhysics::ToFIntPoint(FVector2D position)
@@ -486,66 +1017,90 @@ int BlockPhysics::ToInt(float value)
 	return FGenericPlatformMath::RoundToInt(value);
 }
 
-Block BlockPhysics::GetRandomBlock()
+void BlockPhysics::GenerateRefillColorIndices(int count)
 {
-	const auto normalBlocks = GetNormalBlocks();
-	return normalBlocks[newBlockGenerator() % normalBlocks.Num()];
+	if (!newBlockGenerator) {
+		randomGenerator.FillInRange(validColors.Num(), count, refillColorIndices);
+		return;
+	}
+
+	refillColorIndices.Reset();
+	for (int i = 0; i < count; i++) {
+		refillColorIndices.Add(newBlockGenerator() % validColors.Num());
+	}
 }
 
 FIntPoint BlockPhysics::GetRandomOrthogonalDirectionFrom(FIntPoint direction)
 {
 	auto ret = FIntPoint{ -direction.Y, direction.X };
-	if (randomDirectionGenerator() % 2 == 1)
+	const auto randomBit = randomDirectionGenerator ? randomDirectionGenerator() % 2 : randomGenerator.NextInRange(2);
+	if (randomBit == 1)
 		ret = FIntPoint{ -ret.X, -ret.Y };
 	return ret;
 }
 
-PhysicalBlock::PhysicalBlock(Block block, FIntPoint initialPosition, TUniquePtr<BlockAction>&& action)
-	: block(block), currentAction(MoveTemp(action)), id(++lastIssuedId)
+PhysicalBlock::PhysicalBlock(Block block, BlockHandle handle, TUniquePtr<BlockAction>&& action)
+	: block(block), currentAction(MoveTemp(action)), handle(handle)
 {
 }
 
-PhysicalBlock::PhysicalBlock(Block block, FIntPoint initialPosition)
-	: block(block), currentAction(MakeUnique<IdleBlockAction>(initialPosition)), id(++lastIssuedId)
+PhysicalBlock::PhysicalBlock(Block block, FIntPoint initialPosition, BlockHandle handle)
+	: block(block), currentAction(MakeUnique<IdleBlockAction>(initialPosition)), handle(handle)
 {
 
 }
 
 PhysicalBlock::PhysicalBlock(PhysicalBlock&& other)
-	: block(other.block), currentAction(MoveTemp(other.currentAction)), id(++lastIssuedId)
+	: block(other.block), currentAction(MoveTemp(other.currentAction)), wasGettingDestroyedAtTickStart(other.wasGettingDestroyedAtTickStart), logicalGridIndex(other.logicalGridIndex), handle(other.handle)
 {
 
 }
 
-PhysicalBlockSnapShot PhysicalBlock::GetSnapShot() const
+PhysicalBlock& PhysicalBlock::operator=(PhysicalBlock&& other)
 {
-	return PhysicalBlockSnapShot(id, block, currentAction->GetType(), currentAction->GetPosition());
+	block = other.block;
+	currentAction = MoveTemp(other.currentAction);
+	wasGettingDestroyedAtTickStart = other.wasGettingDestroyedAtTickStart;
+	logicalGridIndex = other.logicalGridIndex;
+	handle = other.handle;
+	return *this;
 }
 
-int PhysicalBlock::lastIssuedId = -1;
-
-PhysicalBlocksSnapShotDiff::PhysicalBlocksSnapShotDiff(const TArray<PhysicalBlockSnapShot>& before, const TArray<PhysicalBlockSnapShot>& after)
-	: before(before), after(after)
+PhysicalBlock PhysicalBlock::Clone(BlockPhysics& owner) const
 {
-
+	auto ret = PhysicalBlock(block, handle, currentAction->Clone(owner));
+	ret.wasGettingDestroyedAtTickStart = wasGettingDestroyedAtTickStart;
+	ret.logicalGridIndex = logicalGridIndex;
+	return ret;
 }
 
-TSet<int> PhysicalBlocksSnapShotDiff::GetJustDestroyedBlockIds() const
+PhysicalBlockSnapShot PhysicalBlock::GetSnapShot() const
 {
-	auto ret = TSet<int>();
-	for (const auto& afterBlockSnapshot : after) {
-		const auto isDestroyingNow = afterBlockSnapshot.actionType == ActionType::GetsDestroyed;
-		if (isDestroyingNow && WasNotDestroyingBefore(afterBlockSnapshot.id))
-			ret.Add(afterBlockSnapshot.id);
-	}
-	return ret;
+	return PhysicalBlockSnapShot(handle, block, currentAction->GetType(), currentAction->GetPosition());
 }
 
-bool PhysicalBlocksSnapShotDiff::WasNotDestroyingBefore(int blockId) const
+
+#if BLOCK_PHYSICS_TRACE_ENABLED
+void BlockPhysics::RecordTrace(BlockTraceEventType eventType, const PhysicalBlock* block, FVector2D position, FVector2D argument)
 {
-	for (const auto& beforeBlockSnapshot : before) {
-		if (beforeBlockSnapshot.id == blockId)
-			return beforeBlockSnapshot.actionType != ActionType::GetsDestroyed;
+	if (!trace.IsValid())
+		return;
+
+	auto record = BlockTraceRecord();
+	record.elapsedTime = elapsedTime;
+	record.eventType = eventType;
+	if (block != nullptr) {
+		record.blockCode = static_cast<uint8>(block->block.GetColor()) | (static_cast<uint8>(block->block.GetSpecialAttribute()) << 4);
+		record.actionType = static_cast<uint8>(block->currentAction->GetType());
+		record.handleIndex = block->GetHandle().GetIndex();
 	}
-	return true;
+	record.positionX = static_cast<int16>(FMath::RoundToInt(position.X * BlockTraceRecord::POSITION_SCALE));
+	record.positionY = static_cast<int16>(FMath::RoundToInt(position.Y * BlockTraceRecord::POSITION_SCALE));
+	record.argumentX = static_cast<int16>(FMath::RoundToInt(argument.X * BlockTraceRecord::POSITION_SCALE));
+	record.argumentY = static_cast<int16>(FMath::RoundToInt(argument.Y * BlockTraceRecord::POSITION_SCALE));
+	trace->Record(record);
+
+	if (enableTickDebugLog && UE_LOG_ACTIVE(LogBlockPhysics, Verbose))
+		UE_LOG(LogBlockPhysics, Verbose, TEXT("%s"), *BlockPhysicsTraceDecoder::ToText(record));
 }
+#endif
@@ -0,0 +1,356 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BlockPhysicsBenchCommandlet.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/Parse.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+#include "BlockPhysics.h"
+#include "BlockMatrix.h"
+#include "BlockRandomGenerator.h"
+#include "BlockPhysicsTrace.h"
+#include "ScopedAllocationCounter.h"
+
+namespace {
+	enum class BenchWorkload {
+		NormalSwaps,
+		RandomSwipes,
+		MunchickenRolls,
+		LineClearChains
+	};
+	const TArray<BenchWorkload> allWorkloads = TArray<BenchWorkload>{
+		BenchWorkload::NormalSwaps, BenchWorkload::RandomSwipes, BenchWorkload::MunchickenRolls, BenchWorkload::LineClearChains
+	};
+
+	FString ToString(BenchWorkload workload)
+	{
+		switch (workload) {
+		case BenchWorkload::NormalSwaps:
+			return TEXT("NormalSwaps");
+		case BenchWorkload::RandomSwipes:
+			return TEXT("RandomSwipes");
+		case BenchWorkload::MunchickenRolls:
+			return TEXT("MunchickenRolls");
+		case BenchWorkload::LineClearChains:
+			return TEXT("LineClearChains");
+		default:
+			return TEXT("");
+		}
+	}
+
+	constexpr float TICK_SECONDS = 1.f / 60.f;
+	constexpr int MAX_TICKS_PER_CASCADE = 60 * 60;
+	constexpr int DEFAULT_NUM_SWIPES = 20;
+	constexpr uint64 DEFAULT_SEED = 1;
+	const TArray<FIntPoint> swipeDirections = TArray<FIntPoint>{ {0, 1}, {1, 0}, {0, -1}, {-1, 0} };
+
+	using BlockGrid = TArray<TArray<Block>>;
+
+	bool IsInside(const BlockGrid& grid, FIntPoint position)
+	{
+		return position.X >= 0 && position.Y >= 0 && position.X < grid.Num() && position.Y < grid[0].Num();
+	}
+
+	bool HasSameColor(const BlockGrid& grid, FIntPoint position, BlockColor color)
+	{
+		if (!IsInside(grid, position))
+			return false;
+		const auto& block = grid[position.X][position.Y];
+		return HasColor(block.GetSpecialAttribute()) && block.GetColor() == color;
+	}
+
+	// Whether the block at position is part of a three-line or a square, which covers every rule in MatchRules.
+	bool IsPartOfMatch(const BlockGrid& grid, FIntPoint position)
+	{
+		const auto& block = grid[position.X][position.Y];
+		if (!HasColor(block.GetSpecialAttribute()))
+			return false;
+		const auto color = block.GetColor();
+		for (const auto& axis : { FIntPoint{ 0, 1 }, FIntPoint{ 1, 0 } }) {
+			auto lineLength = 1;
+			for (auto cursor = position + axis; HasSameColor(grid, cursor, color); cursor += axis)
+				lineLength++;
+			for (auto cursor = position - axis; HasSameColor(grid, cursor, color); cursor -= axis)
+				lineLength++;
+			if (lineLength >= 3)
+				return true;
+		}
+		for (const auto& corner : { FIntPoint{ 1, 1 }, FIntPoint{ 1, -1 }, FIntPoint{ -1, 1 }, FIntPoint{ -1, -1 } }) {
+			if (HasSameColor(grid, position + FIntPoint{ corner.X, 0 }, color)
+				&& HasSameColor(grid, position + FIntPoint{ 0, corner.Y }, color)
+				&& HasSameColor(grid, position + corner, color))
+				return true;
+		}
+		return false;
+	}
+
+	BlockGrid MakeInitialGrid(int size, BenchWorkload workload, BlockRandomGenerator& randomGenerator)
+	{
+		auto grid = BlockGrid();
+		grid.SetNum(size);
+		for (auto& row : grid)
+			row.Init(Block::INVALID, size);
+
+		for (int i = 0; i < size; i++) {
+			for (int j = 0; j < size; j++) {
+				do {
+					grid[i][j] = Block(validColors[randomGenerator.NextInRange(validColors.Num())], BlockSpecialAttribute::NONE);
+				} while (IsPartOfMatch(grid, FIntPoint{ i, j }));
+			}
+		}
+
+		if (workload == BenchWorkload::MunchickenRolls) {
+			const auto numMunchickens = size * size / 10 + 1;
+			for (int i = 0; i < numMunchickens; i++)
+				grid[randomGenerator.NextInRange(size)][randomGenerator.NextInRange(size)] = Block::MUNCHICKEN;
+		}
+		else if (workload == BenchWorkload::LineClearChains) {
+			const auto numLineClearers = size * size / 8 + 1;
+			for (int i = 0; i < numLineClearers; i++) {
+				auto& block = grid[randomGenerator.NextInRange(size)][randomGenerator.NextInRange(size)];
+				if (!HasColor(block.GetSpecialAttribute()))
+					continue;
+				const auto attribute = randomGenerator.NextInRange(2) == 0 ? BlockSpecialAttribute::VERTICAL_LINE_CLEAR : BlockSpecialAttribute::HORIZONTAL_LINE_CLEAR;
+				block = Block(block.GetColor(), attribute);
+			}
+		}
+		return grid;
+	}
+
+	class Swipe {
+	public:
+		FIntPoint start;
+		FIntPoint end;
+	};
+
+	Swipe PickRandomSwipe(const BlockGrid& grid, BlockRandomGenerator& randomGenerator)
+	{
+		while (true) {
+			const auto start = FIntPoint{ randomGenerator.NextInRange(grid.Num()), randomGenerator.NextInRange(grid[0].Num()) };
+			const auto end = start + swipeDirections[randomGenerator.NextInRange(swipeDirections.Num())];
+			if (IsInside(grid, end))
+				return Swipe{ start, end };
+		}
+	}
+
+	// Scans from a random cell in row-major order; a swap involving a special block wins if preferSpecial is set.
+	bool FindMatchingSwipe(BlockGrid& grid, BlockRandomGenerator& randomGenerator, bool preferSpecial, Swipe& outSwipe)
+	{
+		const auto numRows = grid.Num();
+		const auto numCols = grid[0].Num();
+		const auto numCells = numRows * numCols;
+		const auto firstCell = randomGenerator.NextInRange(numCells);
+		auto found = false;
+		for (int k = 0; k < numCells; k++) {
+			const auto cell = (firstCell + k) % numCells;
+			const auto start = FIntPoint{ cell / numCols, cell % numCols };
+			for (const auto& direction : { FIntPoint{ 0, 1 }, FIntPoint{ 1, 0 } }) {
+				const auto end = start + direction;
+				if (!IsInside(grid, end))
+					continue;
+				Swap(grid[start.X][start.Y], grid[end.X][end.Y]);
+				const auto isMatching = IsPartOfMatch(grid, start) || IsPartOfMatch(grid, end);
+				Swap(grid[start.X][start.Y], grid[end.X][end.Y]);
+				if (!isMatching)
+					continue;
+				const auto isSpecial = grid[start.X][start.Y].IsSpecial() || grid[end.X][end.Y].IsSpecial();
+				if (!found || (preferSpecial && isSpecial)) {
+					outSwipe = Swipe{ start, end };
+					found = true;
+				}
+				if (!preferSpecial || isSpecial)
+					return true;
+			}
+		}
+		return found;
+	}
+
+	bool FindMunchickenSwipe(const BlockGrid& grid, BlockRandomGenerator& randomGenerator, Swipe& outSwipe)
+	{
+		for (int i = 0; i < grid.Num(); i++) {
+			for (int j = 0; j < grid[i].Num(); j++) {
+				if (grid[i][j] != Block::MUNCHICKEN)
+					continue;
+				const auto start = FIntPoint{ i, j };
+				outSwipe = Swipe{ start, start + swipeDirections[randomGenerator.NextInRange(swipeDirections.Num())] };
+				return true;
+			}
+		}
+		return false;
+	}
+
+	Swipe PickSwipe(BenchWorkload workload, BlockGrid& grid, BlockRandomGenerator& randomGenerator)
+	{
+		auto swipe = Swipe();
+		switch (workload) {
+		case BenchWorkload::MunchickenRolls:
+			if (FindMunchickenSwipe(grid, randomGenerator, swipe))
+				return swipe;
+			break;
+		case BenchWorkload::LineClearChains:
+			if (FindMatchingSwipe(grid, randomGenerator, true, swipe))
+				return swipe;
+			break;
+		case BenchWorkload::NormalSwaps:
+			if (FindMatchingSwipe(grid, randomGenerator, false, swipe))
+				return swipe;
+			break;
+		default:
+			break;
+		}
+		return PickRandomSwipe(grid, randomGenerator);
+	}
+
+	template <typename T>
+	T Percentile(const TArray<T>& sortedValues, double percentile)
+	{
+		if (sortedValues.Num() == 0)
+			return T();
+		const auto index = FMath::Clamp(FMath::CeilToInt(percentile * sortedValues.Num()) - 1, 0, sortedValues.Num() - 1);
+		return sortedValues[index];
+	}
+
+	template <typename T>
+	double Mean(const TArray<T>& values)
+	{
+		if (values.Num() == 0)
+			return 0.0;
+		auto sum = 0.0;
+		for (const auto value : values)
+			sum += value;
+		return sum / values.Num();
+	}
+
+	template <typename T>
+	TSharedRef<FJsonObject> MakeDistributionJson(TArray<T> values)
+	{
+		values.Sort();
+		auto ret = MakeShared<FJsonObject>();
+		ret->SetNumberField(TEXT("mean"), Mean(values));
+		ret->SetNumberField(TEXT("p50"), Percentile(values, 0.5));
+		ret->SetNumberField(TEXT("p90"), Percentile(values, 0.9));
+		ret->SetNumberField(TEXT("p99"), Percentile(values, 0.99));
+		ret->SetNumberField(TEXT("max"), values.Num() == 0 ? T() : values.Last());
+		return ret;
+	}
+
+	TSharedRef<FJsonObject> RunScenario(int size, BenchWorkload workload, int numSwipes, uint64 seed)
+	{
+		auto randomGenerator = BlockRandomGenerator(seed);
+		auto grid = MakeInitialGrid(size, workload, randomGenerator);
+		auto blockPhysics = BlockPhysics(BlockMatrix(grid), seed);
+		blockPhysics.DisableTickDebugLog();
+
+		const auto usedPhysicalBefore = FPlatformMemory::GetStats().UsedPhysical;
+		auto nanosecondsPerTick = TArray<double>();
+		auto allocationsPerTick = TArray<uint64>();
+		auto allocatedBytesPerTick = TArray<uint64>();
+		auto ticksPerCascade = TArray<int32>();
+		auto allocationCounter = ScopedAllocationCounter();
+		for (int swipeIndex = 0; swipeIndex < numSwipes; swipeIndex++) {
+			grid = blockPhysics.GetBlockMatrix().GetBlock2DArray();
+			const auto swipe = PickSwipe(workload, grid, randomGenerator);
+			blockPhysics.ReceiveSwipeInput(swipe.start, swipe.end);
+
+			auto numTicks = 0;
+			do {
+				allocationCounter.Restart();
+				const auto startCycles = FPlatformTime::Cycles64();
+				blockPhysics.Tick(TICK_SECONDS);
+				const auto endCycles = FPlatformTime::Cycles64();
+				nanosecondsPerTick.Add(FPlatformTime::ToSeconds64(endCycles - startCycles) * 1e9);
+				allocationsPerTick.Add(allocationCounter.GetNumAllocations());
+				allocatedBytesPerTick.Add(allocationCounter.GetNumAllocatedBytes());
+				numTicks++;
+			} while (blockPhysics.IsInAction() && numTicks < MAX_TICKS_PER_CASCADE);
+			ticksPerCascade.Add(numTicks);
+			if (numTicks == MAX_TICKS_PER_CASCADE)
+				UE_LOG(LogBlockPhysics, Warning, TEXT("%s %dx%d: cascade after swipe %d did not settle"), *ToString(workload), size, size, swipeIndex);
+		}
+		const auto memoryStats = FPlatformMemory::GetStats();
+
+		auto ret = MakeShared<FJsonObject>();
+		ret->SetStringField(TEXT("workload"), ToString(workload));
+		ret->SetNumberField(TEXT("rows"), size);
+		ret->SetNumberField(TEXT("cols"), size);
+		ret->SetNumberField(TEXT("seed"), static_cast<double>(seed));
+		ret->SetNumberField(TEXT("swipes"), numSwipes);
+		ret->SetNumberField(TEXT("ticks"), nanosecondsPerTick.Num());
+		ret->SetObjectField(TEXT("nsPerTick"), MakeDistributionJson(nanosecondsPerTick));
+		ret->SetObjectField(TEXT("ticksPerCascade"), MakeDistributionJson(ticksPerCascade));
+		ret->SetObjectField(TEXT("allocationsPerTick"), MakeDistributionJson(allocationsPerTick));
+		ret->SetObjectField(TEXT("allocatedBytesPerTick"), MakeDistributionJson(allocatedBytesPerTick));
+		ret->SetNumberField(TEXT("usedPhysicalDeltaBytes"), static_cast<double>(memoryStats.UsedPhysical) - static_cast<double>(usedPhysicalBefore));
+		ret->SetNumberField(TEXT("peakUsedPhysicalBytes"), static_cast<double>(memoryStats.PeakUsedPhysical));
+		UE_LOG(LogBlockPhysics, Display, TEXT("%s %dx%d: %d ticks, p50 %.0f ns"),
+			*ToString(workload), size, size, nanosecondsPerTick.Num(), ret->GetObjectField(TEXT("nsPerTick"))->GetNumberField(TEXT("p50")));
+		return ret;
+	}
+
+	TArray<int32> ParseSizes(const FString& params)
+	{
+		const auto maxSize = BlockPhysics::MAX_ROW_COL_SIZE;
+		auto ret = TArray<int32>();
+		auto sizesString = FString();
+		if (FParse::Value(*params, TEXT("Sizes="), sizesString)) {
+			auto sizeStrings = TArray<FString>();
+			sizesString.ParseIntoArray(sizeStrings, TEXT(","));
+			for (const auto& sizeString : sizeStrings)
+				ret.Add(FMath::Clamp(FCString::Atoi(*sizeString), 3, maxSize));
+		}
+		else {
+			for (auto size = 5; size < maxSize; size *= 2)
+				ret.Add(size);
+			ret.Add(maxSize);
+		}
+		return ret;
+	}
+}
+
+UBlockPhysicsBenchCommandlet::UBlockPhysicsBenchCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UBlockPhysicsBenchCommandlet::Main(const FString& Params)
+{
+	auto seed = DEFAULT_SEED;
+	FParse::Value(*Params, TEXT("Seed="), seed);
+	auto numSwipes = DEFAULT_NUM_SWIPES;
+	FParse::Value(*Params, TEXT("Swipes="), numSwipes);
+	auto outputPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Profiling"), TEXT("BlockPhysicsBench.json"));
+	FParse::Value(*Params, TEXT("Output="), outputPath);
+
+	if (!ScopedAllocationCounter::IsCounting())
+		UE_LOG(LogBlockPhysics, Warning, TEXT("Allocation counting is unavailable; allocationsPerTick will be zero"));
+
+	auto scenarios = TArray<TSharedPtr<FJsonValue>>();
+	for (const auto size : ParseSizes(Params)) {
+		for (const auto workload : allWorkloads) {
+			const auto scenarioSeed = seed + static_cast<uint64>(size) * 1000003ull + static_cast<uint64>(workload);
+			scenarios.Add(MakeShared<FJsonValueObject>(RunScenario(size, workload, numSwipes, scenarioSeed)));
+		}
+	}
+
+	auto root = MakeShared<FJsonObject>();
+	root->SetNumberField(TEXT("seed"), static_cast<double>(seed));
+	root->SetNumberField(TEXT("tickSeconds"), TICK_SECONDS);
+	root->SetArrayField(TEXT("scenarios"), scenarios);
+	auto json = FString();
+	const auto writer = TJsonWriterFactory<>::Create(&json);
+	FJsonSerializer::Serialize(root, writer);
+
+	if (!FFileHelper::SaveStringToFile(json, *outputPath)) {
+		UE_LOG(LogBlockPhysics, Error, TEXT("Could not write benchmark result to %s"), *outputPath);
+		return 1;
+	}
+	UE_LOG(LogBlockPhysics, Display, TEXT("Benchmark result written to %s"), *outputPath);
+	return 0;
+}
@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BlockPhysicsBot.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+
+namespace {
+	const FIntPoint swipeDirections[] = { FIntPoint{ 0, 1 }, FIntPoint{ 1, 0 }, FIntPoint{ 0, -1 }, FIntPoint{ -1, 0 } };
+}
+
+BlockPhysicsBot::BlockPhysicsBot(uint64 seed)
+	:seed(seed), matchCache(MakeShared<BoardHashCache<TSet<Match>>, ESPMode::ThreadSafe>()), swipeCache(MakeShared<BoardHashCache<TArray<BlockSwipe>>, ESPMode::ThreadSafe>())
+{
+}
+
+TArray<BlockSwipe> BlockPhysicsBot::GetAvailableSwipes(const BlockPhysics& blockPhysics)
+{
+	auto ret = TArray<BlockSwipe>();
+	if (blockPhysics.IsInAction())
+		return ret;
+
+	// On a settled board the logical grid holds every block.
+	const auto& grid = blockPhysics.GetBlockMatrix();
+	for (int row = 0; row < grid.GetNumRows(); row++) {
+		for (int col = 0; col < grid.GetNumCols(); col++) {
+			const auto start = FIntPoint{ row, col };
+			const auto startBlock = grid.At(row, col);
+			if (startBlock == Block::INVALID)
+				continue;
+			for (const auto& direction : swipeDirections) {
+				const auto end = start + direction;
+				const auto endBlock = grid.At(end.X, end.Y);
+				if (startBlock == Block::MUNCHICKEN) {
+					const auto isEndInBoard = (0 <= end.X) && (end.X < grid.GetNumRows()) && (0 <= end.Y) && (end.Y < grid.GetNumCols());
+					if (isEndInBoard)
+						ret.Add(BlockSwipe(start, end));
+					continue;
+				}
+				if (endBlock == Block::INVALID)
+					continue;
+				// Swapping two normal blocks is the same move from either side, so keep one direction of each pair.
+				const auto isForward = (direction.X + direction.Y) > 0;
+				if (isForward || endBlock == Block::MUNCHICKEN)
+					ret.Add(BlockSwipe(start, end));
+			}
+		}
+	}
+	return ret;
+}
+
+TArray<SwipeEvaluation> BlockPhysicsBot::EvaluateSwipes(const BlockPhysics& blockPhysics, double timeBudgetSeconds, int maxRounds) const
+{
+	auto ret = TArray<SwipeEvaluation>();
+	auto swipes = TArray<BlockSwipe>();
+	const auto cachedSwipes = blockPhysics.IsInAction() ? nullptr : swipeCache->Find(blockPhysics.GetBoardHash());
+	if (cachedSwipes) {
+		swipes = *cachedSwipes;
+	}
+	else {
+		swipes = GetAvailableSwipes(blockPhysics);
+		if (swipes.Num() > 0)
+			swipeCache->Add(blockPhysics.GetBoardHash(), swipes);
+	}
+	for (const auto& swipe : swipes) {
+		ret.Add(SwipeEvaluation(swipe));
+	}
+	if (ret.Num() == 0)
+		return ret;
+
+	const auto deadline = FPlatformTime::Seconds() + timeBudgetSeconds;
+	const auto numJobs = ret.Num() * ROLLOUTS_PER_ROUND;
+	auto scores = TArray<int32>();
+	scores.SetNumZeroed(numJobs);
+	auto round = uint64(0);
+	while (round < static_cast<uint64>(maxRounds) && FPlatformTime::Seconds() < deadline) {
+		ParallelFor(numJobs, [&](int32 jobIndex) {
+			// A round holds thousands of rollouts on a big board, so the deadline can't wait for its end.
+			if (FPlatformTime::Seconds() >= deadline) {
+				scores[jobIndex] = INDEX_NONE;
+				return;
+			}
+			const auto swipeIndex = jobIndex / ROLLOUTS_PER_ROUND;
+			const auto rolloutIndex = jobIndex % ROLLOUTS_PER_ROUND;
+			// Every swipe sees the same refills for a given rollout, so differences between swipes aren't just noise.
+			const auto rolloutSeed = seed + round * ROLLOUTS_PER_ROUND + rolloutIndex;
+			scores[jobIndex] = RollOut(blockPhysics, ret[swipeIndex].swipe, rolloutSeed);
+		});
+		for (int jobIndex = 0; jobIndex < numJobs; jobIndex++) {
+			if (scores[jobIndex] == INDEX_NONE)
+				continue;
+			auto& evaluation = ret[jobIndex / ROLLOUTS_PER_ROUND];
+			evaluation.totalScore += scores[jobIndex];
+			evaluation.numRollouts++;
+		}
+		round++;
+	}
+	return ret;
+}
+
+int BlockPhysicsBot::RollOut(const BlockPhysics& blockPhysics, const BlockSwipe& swipe, uint64 rolloutSeed) const
+{
+	auto rollout = blockPhysics.Clone();
+	rollout.DisableTickDebugLog();
+	rollout.SetMatchCache(matchCache);
+	rollout.SetRandomSeed(rolloutSeed);
+	rollout.ReceiveSwipeInput(swipe.start, swipe.end);
+	auto score = 0;
+	for (int i = 0; i < MAX_TICKS_PER_ROLLOUT; i++) {
+		rollout.Tick(LOGICAL_TICK_SECONDS);
+		score += rollout.GetScoreInThisTick();
+		if (!rollout.IsInAction())
+			break;
+	}
+	return score;
+}
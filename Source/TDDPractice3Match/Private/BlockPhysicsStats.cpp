@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BlockPhysicsStats.h"
+
+DEFINE_STAT(STAT_BlockPhysicsTick);
+DEFINE_STAT(STAT_BlockPhysicsTickActions);
+DEFINE_STAT(STAT_BlockPhysicsCheckMatch);
+DEFINE_STAT(STAT_BlockPhysicsResolveExplosions);
+DEFINE_STAT(STAT_BlockPhysicsRemoveDeadBlocks);
+DEFINE_STAT(STAT_BlockPhysicsChangeActions);
+DEFINE_STAT(STAT_BlockPhysicsFallAndRefill);
+DEFINE_STAT(STAT_BlockPhysicsUpdateBlockActors);
+
+DEFINE_STAT(STAT_BlockPhysicsBlocksTicked);
+DEFINE_STAT(STAT_BlockPhysicsMatchesFound);
+DEFINE_STAT(STAT_BlockPhysicsActionAllocations);
+DEFINE_STAT(STAT_BlockPhysicsActorsSpawned);
+DEFINE_STAT(STAT_BlockPhysicsActorsDestroyed);
+DEFINE_STAT(STAT_BlockPhysicsActorPoolHits);
+DEFINE_STAT(STAT_BlockPhysicsActorPoolMisses);
+
+CSV_DEFINE_CATEGORY_MODULE(TDDPRACTICE3MATCH_API, BlockPhysics, true);
@@ -3,8 +3,9 @@
 #include "BlockPhysicsTester.h"
 #include "BlockPhysics.h"
 #include "BlockMatrix.h"
+#include "ScopedAllocationCounter.h"
 
-BlockPhysicsTester::BlockPhysicsTester(const BlockMatrix& initialBlockMatrix, TFunction<int(void)> randomGeneratorForNewBlock /*= rand*/, TFunction<int(void)> randomGeneratorForDirection /*=rand*/)
+BlockPhysicsTester::BlockPhysicsTester(const BlockMatrix& initialBlockMatrix, TFunction<int(void)> randomGeneratorForNewBlock /*= nullptr*/, TFunction<int(void)> randomGeneratorForDirection /*= nullptr*/)
 	: blockPhysics(MakeUnique<BlockPhysics>(initialBlockMatrix, randomGeneratorForNewBlock, randomGeneratorForDirection)), tickDivider(1)
 {
 
@@ -204,10 +205,56 @@ void BlockPhysicsTester::TestIsInAction(bool expectedValue) const
 		UE_LOG(LogTemp, Error, TEXT("blockPhysics->IsInAction() should be %s but it's not"), expectedValue ? TEXT("true") : TEXT("false"));
 }
 
+void BlockPhysicsTester::StartTrackingAllocations()
+{
+	isTrackingAllocations = true;
+	numTrackedTicks = 0;
+	maxAllocationsPerTick = 0;
+	maxAllocatedBytesPerTick = 0;
+	if (!ScopedAllocationCounter::IsCounting())
+		UE_LOG(LogTemp, Warning, TEXT("Allocation counting is unavailable; allocation budgets can't be tested"));
+}
+
+void BlockPhysicsTester::TestAllocationsPerTickWithin(uint64 maxAllocations, uint64 maxAllocatedBytes) const
+{
+	if (numTrackedTicks == 0)
+		UE_LOG(LogTemp, Error, TEXT("No tick was tracked; call StartTrackingAllocations before ticking"));
+	if (maxAllocationsPerTick > maxAllocations)
+		UE_LOG(LogTemp, Error, TEXT("A tick allocated %llu times, over the budget of %llu"), maxAllocationsPerTick, maxAllocations);
+	if (maxAllocatedBytesPerTick > maxAllocatedBytes)
+		UE_LOG(LogTemp, Error, TEXT("A tick allocated %llu bytes, over the budget of %llu"), maxAllocatedBytesPerTick, maxAllocatedBytes);
+}
+
+void BlockPhysicsTester::TestGetMatchesAllocationsWithin(uint64 maxAllocations, uint64 maxAllocatedBytes) const
+{
+	const auto blockMatrix = blockPhysics->GetBlockMatrix();
+	auto numAllocations = uint64(0);
+	auto numAllocatedBytes = uint64(0);
+	{
+		const auto allocationCounter = ScopedAllocationCounter();
+		const auto matches = blockMatrix.GetMatches();
+		numAllocations = allocationCounter.GetNumAllocations();
+		numAllocatedBytes = allocationCounter.GetNumAllocatedBytes();
+	}
+	if (numAllocations > maxAllocations)
+		UE_LOG(LogTemp, Error, TEXT("GetMatches allocated %llu times, over the budget of %llu"), numAllocations, maxAllocations);
+	if (numAllocatedBytes > maxAllocatedBytes)
+		UE_LOG(LogTemp, Error, TEXT("GetMatches allocated %llu bytes, over the budget of %llu"), numAllocatedBytes, maxAllocatedBytes);
+}
+
 void BlockPhysicsTester::TickFor(float deltaSeconds)
 {
 	for (int i = 0; i < tickDivider; i++) {
-		blockPhysics->Tick(deltaSeconds / tickDivider);
+		if (isTrackingAllocations) {
+			const auto allocationCounter = ScopedAllocationCounter();
+			blockPhysics->Tick(deltaSeconds / tickDivider);
+			maxAllocationsPerTick = FMath::Max(maxAllocationsPerTick, allocationCounter.GetNumAllocations());
+			maxAllocatedBytesPerTick = FMath::Max(maxAllocatedBytesPerTick, allocationCounter.GetNumAllocatedBytes());
+			numTrackedTicks++;
+		}
+		else {
+			blockPhysics->Tick(deltaSeconds / tickDivider);
+		}
 		if (i != tickDivider - 1)
 			duringFrequentTickTest(*this);
 		onTickEndTest(*this);
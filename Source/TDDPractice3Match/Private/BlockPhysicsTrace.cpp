@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BlockPhysicsTrace.h"
+
+DEFINE_LOG_CATEGORY(LogBlockPhysics);
+
+void BlockPhysicsTrace::Record(const BlockTraceRecord& record)
+{
+	const auto cursor = writeCursor.Load(EMemoryOrder::Relaxed);
+	records[cursor & (CAPACITY - 1)] = record;
+	writeCursor.Store(cursor + 1);
+}
+
+void BlockPhysicsTrace::CopyRecords(TArray<BlockTraceRecord>& outRecords) const
+{
+	outRecords.Reset();
+	const auto endCursor = writeCursor.Load();
+	const auto beginCursor = endCursor > CAPACITY ? endCursor - CAPACITY : 0;
+	for (auto cursor = beginCursor; cursor != endCursor; cursor++) {
+		outRecords.Add(records[cursor & (CAPACITY - 1)]);
+	}
+
+	// Records the producer may have overwritten during the copy are the oldest ones; drop them.
+	const auto cursorAfterCopy = writeCursor.Load();
+	const auto firstIntactCursor = cursorAfterCopy > CAPACITY ? cursorAfterCopy - CAPACITY : 0;
+	if (firstIntactCursor > beginCursor) {
+		const auto numOverwritten = FGenericPlatformMath::Min(static_cast<int32>(firstIntactCursor - beginCursor), outRecords.Num());
+		outRecords.RemoveAt(0, numOverwritten);
+	}
+}
@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BlockPhysicsTraceDecoder.h"
+#include "Block.h"
+#include "BlockAction.h"
+
+namespace {
+	Block DecodeBlock(uint8 blockCode)
+	{
+		return Block(static_cast<BlockColor>(blockCode & 0x0F), static_cast<BlockSpecialAttribute>(blockCode >> 4));
+	}
+
+	float DecodePosition(int16 fixedPosition)
+	{
+		return fixedPosition / BlockTraceRecord::POSITION_SCALE;
+	}
+}
+
+FString BlockPhysicsTraceDecoder::ToText(BlockTraceEventType eventType)
+{
+	switch (eventType) {
+	case BlockTraceEventType::TickStart:
+		return TEXT("TickStart");
+	case BlockTraceEventType::ActionCompleted:
+		return TEXT("ActionCompleted");
+	case BlockTraceEventType::MatchChecked:
+		return TEXT("MatchChecked");
+	case BlockTraceEventType::MatchedBlockDestroyStarted:
+		return TEXT("MatchedBlockDestroyStarted");
+	case BlockTraceEventType::SpecialBlockSpawnReserved:
+		return TEXT("SpecialBlockSpawnReserved");
+	case BlockTraceEventType::FallStarted:
+		return TEXT("FallStarted");
+	case BlockTraceEventType::BlockGenerated:
+		return TEXT("BlockGenerated");
+	case BlockTraceEventType::ColumnFull:
+		return TEXT("ColumnFull");
+	case BlockTraceEventType::RolledOver:
+		return TEXT("RolledOver");
+	case BlockTraceEventType::RollableTriggered:
+		return TEXT("RollableTriggered");
+	case BlockTraceEventType::DestroyedInBackground:
+		return TEXT("DestroyedInBackground");
+	default:
+		return TEXT("");
+	}
+}
+
+FString BlockPhysicsTraceDecoder::ToText(const BlockTraceRecord& record)
+{
+	auto ret = FString::Printf(TEXT("[%f] %s"), record.elapsedTime, *ToText(record.eventType));
+	if (record.handleIndex != INDEX_NONE) {
+		ret += FString::Printf(TEXT(" block #%d %s, action %s"), record.handleIndex,
+			*PrettyPrint(DecodeBlock(record.blockCode)), *PrettyPrint(static_cast<ActionType>(record.actionType)));
+	}
+	ret += FString::Printf(TEXT(" at (%f, %f), argument (%f, %f)"),
+		DecodePosition(record.positionX), DecodePosition(record.positionY),
+		DecodePosition(record.argumentX), DecodePosition(record.argumentY));
+	return ret;
+}
+
+TArray<FString> BlockPhysicsTraceDecoder::ToText(const BlockPhysicsTrace& trace)
+{
+	auto records = TArray<BlockTraceRecord>();
+	trace.CopyRecords(records);
+	auto ret = TArray<FString>();
+	ret.Reserve(records.Num());
+	for (const auto& record : records) {
+		ret.Add(ToText(record));
+	}
+	return ret;
+}
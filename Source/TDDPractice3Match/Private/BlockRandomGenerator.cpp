@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BlockRandomGenerator.h"
+
+namespace {
+	uint32 RotateLeft(uint32 value, int shift)
+	{
+		return (value << shift) | (value >> (32 - shift));
+	}
+
+	uint64 SplitMix64(uint64& seedState)
+	{
+		auto z = (seedState += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+}
+
+bool BlockRandomGeneratorState::operator==(const BlockRandomGeneratorState& other) const
+{
+	for (int i = 0; i < 4; i++) {
+		if (words[i] != other.words[i])
+			return false;
+	}
+	return true;
+}
+
+void BlockRandomGenerator::Seed(uint64 seed)
+{
+	auto seedState = seed;
+	const auto first = SplitMix64(seedState);
+	const auto second = SplitMix64(seedState);
+	state.words[0] = static_cast<uint32>(first);
+	state.words[1] = static_cast<uint32>(first >> 32);
+	state.words[2] = static_cast<uint32>(second);
+	state.words[3] = static_cast<uint32>(second >> 32);
+}
+
+uint32 BlockRandomGenerator::Next()
+{
+	auto& s = state.words;
+	const auto result = RotateLeft(s[1] * 5, 7) * 9;
+	const auto t = s[1] << 9;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = RotateLeft(s[3], 11);
+	return result;
+}
+
+int32 BlockRandomGenerator::NextInRange(int32 bound)
+{
+	if (bound <= 1)
+		return 0;
+
+	// Lemire's multiply-shift with rejection of the biased low range.
+	const auto range = static_cast<uint32>(bound);
+	auto product = static_cast<uint64>(Next()) * range;
+	auto low = static_cast<uint32>(product);
+	if (low < range) {
+		const auto threshold = (0u - range) % range;
+		while (low < threshold) {
+			product = static_cast<uint64>(Next()) * range;
+			low = static_cast<uint32>(product);
+		}
+	}
+	return static_cast<int32>(product >> 32);
+}
+
+void BlockRandomGenerator::FillInRange(int32 bound, int32 count, TArray<int32>& outValues)
+{
+	outValues.Reset();
+	outValues.Reserve(count);
+	for (int i = 0; i < count; i++) {
+		outValues.Add(NextInRange(bound));
+	}
+}
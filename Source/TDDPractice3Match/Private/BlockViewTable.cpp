@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BlockViewTable.h"
+
+void BlockViewTable::Slot::Vacate()
+{
+	handle = BlockHandle::INVALID;
+	actor = nullptr;
+	actorKind = INDEX_NONE;
+	actionType = ActionType::Invalid;
+}
+
+void BlockViewTable::Reset()
+{
+	slots.Reset();
+	dirtySlotIndices.Reset();
+}
+
+BlockViewTable::Slot& BlockViewTable::Occupy(BlockHandle handle)
+{
+	auto& slot = GetSlot(handle.GetIndex());
+	slot.Vacate();
+	slot.handle = handle;
+	return slot;
+}
+
+BlockViewTable::Slot* BlockViewTable::Find(BlockHandle handle)
+{
+	if (!handle.IsValid() || handle.GetIndex() >= slots.Num())
+		return nullptr;
+	auto& slot = slots[handle.GetIndex()];
+	return slot.handle == handle ? &slot : nullptr;
+}
+
+void BlockViewTable::MarkDirty(const PhysicalBlocksDelta& delta)
+{
+	for (const auto blockHandle : delta.removed) {
+		if (Find(blockHandle) != nullptr)
+			MarkDirty(blockHandle.GetIndex(), Removed);
+	}
+	for (const auto& physicalBlockSnapShot : delta.spawned) {
+		MarkDirty(physicalBlockSnapShot.handle.GetIndex(), Spawned);
+		slots[physicalBlockSnapShot.handle.GetIndex()].pending = &physicalBlockSnapShot;
+	}
+	for (const auto& physicalBlockSnapShot : delta.changed) {
+		MarkDirty(physicalBlockSnapShot.handle.GetIndex(), Changed);
+		slots[physicalBlockSnapShot.handle.GetIndex()].pending = &physicalBlockSnapShot;
+	}
+}
+
+BlockViewTable::Slot& BlockViewTable::GetSlot(int32 slotIndex)
+{
+	if (slotIndex >= slots.Num())
+		slots.SetNum(slotIndex + 1);
+	return slots[slotIndex];
+}
+
+void BlockViewTable::MarkDirty(int32 slotIndex, DirtyFlag flag)
+{
+	auto& slot = GetSlot(slotIndex);
+	if (slot.dirtyFlags == 0)
+		dirtySlotIndices.Add(slotIndex);
+	slot.dirtyFlags |= flag;
+}
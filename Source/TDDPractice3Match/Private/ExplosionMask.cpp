@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ExplosionMask.h"
+
+void ExplosionMask::Reset(int newNumRows, int newNumCols)
+{
+	numRows = newNumRows;
+	numCols = newNumCols;
+	rowMask.Init(false, numRows);
+	columnMask.Init(false, numCols);
+	cellMask.Init(false, numRows * numCols);
+	cells.Reset();
+	colorMask = 0;
+	containsAnyLine = false;
+}
+
+void ExplosionMask::AddRow(int row)
+{
+	if (!IsRowInBoard(row))
+		return;
+	rowMask[row] = true;
+	containsAnyLine = true;
+}
+
+void ExplosionMask::AddColumn(int col)
+{
+	if (!IsColumnInBoard(col))
+		return;
+	columnMask[col] = true;
+	containsAnyLine = true;
+}
+
+void ExplosionMask::AddCell(FIntPoint cell)
+{
+	if (!IsRowInBoard(cell.X) || !IsColumnInBoard(cell.Y))
+		return;
+	const auto cellIndex = cell.X * numCols + cell.Y;
+	if (cellMask[cellIndex])
+		return;
+	cellMask[cellIndex] = true;
+	cells.Add(cell);
+}
+
+void ExplosionMask::AddDiamond(FIntPoint center, int radius)
+{
+	for (const auto& offset : GetDiamondStencil(radius)) {
+		AddCell(center + offset);
+	}
+}
+
+const TArray<FIntPoint>& ExplosionMask::GetDiamondStencil(int radius)
+{
+	static const auto stencils = []() {
+		auto ret = TArray<TArray<FIntPoint>>();
+		ret.SetNum(MAX_DIAMOND_RADIUS + 1);
+		for (int stencilRadius = 0; stencilRadius <= MAX_DIAMOND_RADIUS; stencilRadius++) {
+			for (int row = -stencilRadius; row <= stencilRadius; row++) {
+				const auto halfWidth = stencilRadius - FMath::Abs(row);
+				for (int col = -halfWidth; col <= halfWidth; col++) {
+					ret[stencilRadius].Add(FIntPoint{ row, col });
+				}
+			}
+		}
+		return ret;
+	}();
+	return stencils[FMath::Clamp(radius, 0, MAX_DIAMOND_RADIUS)];
+}
+
+void ExplosionMask::AddColor(BlockColor color)
+{
+	colorMask |= GetColorBit(color);
+}
+
+bool ExplosionMask::Contains(FIntPoint cell) const
+{
+	if (IsInAnyLine(cell))
+		return true;
+	return IsRowInBoard(cell.X) && IsColumnInBoard(cell.Y) && cellMask[cell.X * numCols + cell.Y];
+}
+
+bool ExplosionMask::IsInAnyLine(FIntPoint cell) const
+{
+	return (IsRowInBoard(cell.X) && rowMask[cell.X]) || (IsColumnInBoard(cell.Y) && columnMask[cell.Y]);
+}
@@ -7,11 +7,13 @@
 #include "../TDDPractice3MatchGameModeBase.h"
 #include "Kismet/GameplayStatics.h"
 #include "GenericPlatform/GenericPlatformMath.h"
+#include "HAL/PlatformTime.h"
 #include "BlockPhysics.h"
+#include "BlockPhysicsTraceDecoder.h"
+#include "BlockPhysicsStats.h"
 #include "BlockMatrix.h"
 #include "BlockActor.h"
 #include "Block.h"
-#include "PaperSpriteComponent.h"
 #include "Sound/SoundWave.h"
 
 
@@ -29,7 +31,7 @@ AMyPlayerController::AMyPlayerController()
 		{ Block::ONE, Block::TWO, Block::THREE, Block::ONE },
 		{ Block::TWO, Block::ZERO, Block::ZERO, Block::THREE },
 		{ Block::ZERO, Block::ZERO, Block::THREE, Block::ZERO }
-	}));
+	}), FPlatformTime::Cycles64());
 	blockPhysics->DisableTickDebugLog();
 }
 
@@ -42,11 +44,32 @@ void AMyPlayerController::Tick(float DeltaSeconds)
 {
 	if (!blockPhysics)
 		return;
-	
+
+	if (!areInitialBlocksSpawned) {
+		SpawnInitialBlocks();
+		areInitialBlocksSpawned = true;
+	}
 	blockPhysics->Tick(DeltaSeconds);
 	UpdateBlocks();
-	AddScore(blockPhysics->GetNumDestroyedBlocksInThisTick() *50);
-	AddScore(ComputeScore(blockPhysics->GetMatchesInThisTick()));
+	AddScore(blockPhysics->GetScoreInThisTick());
+}
+
+void AMyPlayerController::DumpBlockPhysicsTrace()
+{
+#if BLOCK_PHYSICS_TRACE_ENABLED
+	if (!blockPhysics || blockPhysics->GetTrace() == nullptr)
+		return;
+
+	for (const auto& line : BlockPhysicsTraceDecoder::ToText(*blockPhysics->GetTrace())) {
+		UE_LOG(LogBlockPhysics, Display, TEXT("%s"), *line);
+	}
+#endif
+}
+
+void AMyPlayerController::DumpBlockActorPoolStats()
+{
+	UE_LOG(LogTemp, Display, TEXT("Block actor pool: %lld hits, %lld misses, hit rate %.1f%%"),
+		blockActorPool.GetNumHits(), blockActorPool.GetNumMisses(), blockActorPool.GetHitRate() * 100.f);
 }
 
 TWeakObjectPtr<AActor> AMyPlayerController::GetBlockUnderCursor(bool Debug)
@@ -121,8 +144,9 @@ void AMyPlayerController::HandleLeftMouseInput(float value)
 		isDragging = false;
 	}
 	else if (!isDragging && (value > 0.5)) {
+		// Instanced blocks have no actor to hit; the swipe gets checked against the board instead.
 		draggedActor = GetBlockUnderCursor(false);
-		if (draggedActor == nullptr)
+		if (draggedActor == nullptr && !useInstancedBlockRendering)
 			return;
 		FVector unusedDir;
 		DeprojectMousePositionToWorld(dragStart, unusedDir);
@@ -167,169 +191,262 @@ FVector AMyPlayerController::CellCoordinaeToWorldPosition(FVector2D coordinate)
 
 void AMyPlayerController::SpawnInitialBlocks()
 {
-	if (GEngine == nullptr)
-		return;
-
-	GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, "Spawn Initial Blocks");
+	if (GEngine != nullptr)
+		GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, "Spawn Initial Blocks");
 
 	if (blockPhysics == nullptr)
 		return;
 
-	const auto physicalBlockSnapShots = blockPhysics->GetPhysicalBlockSnapShots();
-	for (const auto& physicalBlockSnapShot : physicalBlockSnapShots) {
-		SpawnBlockActor(physicalBlockSnapShot);
+	InitializeInstancedRenderer();
+	if (!useInstancedBlockRendering)
+		PrewarmBlockActorPool();
+	for (const auto& physicalBlockSnapShot : blockPhysics->GetPublishedSnapShots()) {
+		if (useInstancedBlockRendering) {
+			ShowInstancedBlock(physicalBlockSnapShot);
+			blockViews.Occupy(physicalBlockSnapShot.handle).actionType = physicalBlockSnapShot.actionType;
+		}
+		else {
+			SpawnBlockActor(physicalBlockSnapShot);
+		}
 	}
+	instancedRenderer.Flush();
 }
 
 void AMyPlayerController::SpawnBlockActor(const PhysicalBlockSnapShot& physicalBlockSnapShot)
 {
-	auto spawnPosition = CellCoordinaeToWorldPosition(physicalBlockSnapShot.position);
-	auto spawnRotation = FRotator::ZeroRotator;
-	auto spawnResult = SpawnBlockActor(physicalBlockSnapShot, &spawnPosition, &spawnRotation);
+	const auto spawnPosition = GetBlockWorldPosition(physicalBlockSnapShot);
+	const auto spawnRotation = FRotator::ZeroRotator;
+	const auto actorKind = GetActorKind(physicalBlockSnapShot);
+	auto spawnResult = blockActorPool.Acquire(actorKind, spawnPosition, spawnRotation);
+	if (spawnResult == nullptr)
+		spawnResult = SpawnNewBlockActor(actorKind, spawnPosition, spawnRotation);
 	if (spawnResult == nullptr)
 		return;
-	idToBlockActorMap.Add(physicalBlockSnapShot.id, spawnResult);
-	idToActionTypeMap.Add(physicalBlockSnapShot.id, physicalBlockSnapShot.actionType);
+	ShowDecorator(physicalBlockSnapShot, spawnPosition);
+	auto& blockView = blockViews.Occupy(physicalBlockSnapShot.handle);
+	blockView.actor = spawnResult;
+	blockView.actorKind = actorKind;
+	blockView.actionType = physicalBlockSnapShot.actionType;
+}
+
+void AMyPlayerController::PrewarmBlockActorPool()
+{
+	blockActorPool.Reset(NUM_ACTOR_KINDS);
+	const auto hiddenPosition = CellCoordinaeToWorldPosition(FVector2D(-1.f, -1.f));
+	for (int actorKind = 0; actorKind < NUM_ACTOR_KINDS; actorKind++) {
+		const auto numActorsToPrewarm = GetNumActorsToPrewarm(actorKind);
+		for (int i = 0; i < numActorsToPrewarm; i++) {
+			auto actor = SpawnNewBlockActor(actorKind, hiddenPosition, FRotator::ZeroRotator);
+			if (actor == nullptr)
+				break;
+			blockActorPool.Release(actorKind, actor);
+		}
+	}
 }
 
-AActor* AMyPlayerController::SpawnBlockActor(const PhysicalBlockSnapShot& physicalBlockSnapShot, const FVector* spawnPosition, const FRotator* spawnRotation)
+AActor* AMyPlayerController::SpawnNewBlockActor(int actorKind, const FVector& spawnPosition, const FRotator& spawnRotation)
 {
 	auto world = GetWorld();
 	if (world == nullptr)
 		return nullptr;
 
-	FVector yAdjustedSpawnPosition = *spawnPosition + FVector(0, physicalBlockSnapShot.id, 0);
-	if (physicalBlockSnapShot.block.GetSpecialAttribute() == BlockSpecialAttribute::ROLLABLE)
-		yAdjustedSpawnPosition += FVector(0, 200, 0);
-	const auto actionType = physicalBlockSnapShot.actionType;
-	const auto block = physicalBlockSnapShot.block;
-	if (actionType == ActionType::GetsDestroyed) {
-		return world->SpawnActor(
-			explosionActorBlutprintType.Get(),
-			&yAdjustedSpawnPosition,
-			spawnRotation);
-	}
-	else if (block.HasDecoratorAttribute()) {
-		auto ret = world->SpawnActor(
-			blockActorBlueprintType[static_cast<int>(block.GetColor())].Get(),
-			&yAdjustedSpawnPosition,
-			spawnRotation);
-		auto additionalComponent = NewObject<UPaperSpriteComponent>(ret, TEXT("blah"));
-		additionalComponent->SetSimulatePhysics(false);
-		additionalComponent->SetRelativeLocation(FVector(0, 0.5, 0));
-		additionalComponent->RegisterComponent();
-		additionalComponent->SetSprite(horizontalRibbonSprite);
-		additionalComponent->SetRelativeScale3D(FVector(0.5, 1, 0.5));
-		if (block.GetSpecialAttribute() == BlockSpecialAttribute::VERTICAL_LINE_CLEAR)
-			additionalComponent->SetRelativeRotation(FRotator(90, 0, 0));
-		const auto attachResult = additionalComponent->AttachToComponent(ret->GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
-		if (!attachResult)
-			UE_LOG(LogTemp, Error, TEXT("Decorator attach fail"));
-		return ret;
+	AActor* ret = nullptr;
+	if (actorKind == EXPLOSION_ACTOR_KIND) {
+		ret = world->SpawnActor(explosionActorBlutprintType.Get(), &spawnPosition, &spawnRotation);
 	}
-	else if (block.IsSpecial()) {
-		return world->SpawnActor(
-			specialBlockActorBlueprintType[0].Get(),
-			&yAdjustedSpawnPosition,
-			spawnRotation);
+	else if (actorKind >= FIRST_SPECIAL_ACTOR_KIND) {
+		ret = world->SpawnActor(specialBlockActorBlueprintType[actorKind - FIRST_SPECIAL_ACTOR_KIND].Get(), &spawnPosition, &spawnRotation);
 	}
 	else {
-		return world->SpawnActor(
-			blockActorBlueprintType[static_cast<int>(block.GetColor())].Get(),
-			&yAdjustedSpawnPosition,
-			spawnRotation);
+		ret = world->SpawnActor(blockActorBlueprintType[actorKind].Get(), &spawnPosition, &spawnRotation);
 	}
+	if (ret != nullptr)
+		BLOCK_PHYSICS_COUNT(ActorsSpawned, 1);
+	return ret;
 }
 
-void AMyPlayerController::PlayDestroySoundIfNeeded(const PhysicalBlockSnapShot& updatedPhysicalBlock)
+int AMyPlayerController::GetActorKind(const PhysicalBlockSnapShot& physicalBlockSnapShot) const
 {
-	const auto originalActionType = idToActionTypeMap.FindRef(updatedPhysicalBlock.id);
-	const auto justStartedGettingDestroyed = (updatedPhysicalBlock.actionType == ActionType::GetsDestroyed) && (originalActionType != ActionType::GetsDestroyed);
-	if (!justStartedGettingDestroyed)
-		return;
+	const auto block = physicalBlockSnapShot.block;
+	if (physicalBlockSnapShot.actionType == ActionType::GetsDestroyed)
+		return EXPLOSION_ACTOR_KIND;
+	// decorated blocks are plain colored actors; their ribbon is drawn by the instanced renderer
+	if (block.IsSpecial() && !block.HasDecoratorAttribute())
+		return FIRST_SPECIAL_ACTOR_KIND + (block.GetSpecialAttribute() == BlockSpecialAttribute::ONE_COLOR_CLEAR ? 1 : 0);
+	return static_cast<int>(block.GetColor());
+}
 
-	if (updatedPhysicalBlock.block.IsSpecial())
-		PlaySpecialDestroySound();
-	else
-		RandomlyPlayNormalDestorySound();
+FRotator AMyPlayerController::GetDecoratorRotation(BlockSpecialAttribute decorator)
+{
+	if (decorator == BlockSpecialAttribute::VERTICAL_LINE_CLEAR)
+		return FRotator(90, 0, 0);
+	if (decorator == BlockSpecialAttribute::DIAMOND_NEIGHBORHOOD_CLEAR)
+		return FRotator(45, 0, 0);
+	return FRotator::ZeroRotator;
 }
 
-void AMyPlayerController::PlaySpecialDestroySound()
+FVector AMyPlayerController::GetBlockWorldPosition(const PhysicalBlockSnapShot& physicalBlockSnapShot)
 {
-	if (specialBlockPopSound == nullptr)
-		return;
+	// spread in depth by handle so that overlapping blocks don't flicker, with rollables in front
+	auto ret = CellCoordinaeToWorldPosition(physicalBlockSnapShot.position) + FVector(0, physicalBlockSnapShot.handle.GetIndex(), 0);
+	if (physicalBlockSnapShot.block.GetSpecialAttribute() == BlockSpecialAttribute::ROLLABLE)
+		ret += FVector(0, 200, 0);
+	return ret;
+}
 
-	UGameplayStatics::PlaySound2D(this, specialBlockPopSound);
+int AMyPlayerController::GetNumActorsToPrewarm(int actorKind) const
+{
+	if (actorKind >= FIRST_SPECIAL_ACTOR_KIND && actorKind != EXPLOSION_ACTOR_KIND)
+		return NUM_SPECIAL_ACTORS_TO_PREWARM;
+	// no block takes the colorless kind
+	if (actorKind < FIRST_SPECIAL_ACTOR_KIND && !validColors.Contains(static_cast<BlockColor>(actorKind)))
+		return 0;
+	// a color's share of the board, plus a row of refills; the explosion gets as many, for a board-wide clear of one color
+	const auto numRows = blockPhysics->GetNumRows();
+	const auto numCols = blockPhysics->GetNumCols();
+	return numRows * numCols / validColors.Num() + numCols;
 }
 
-void AMyPlayerController::RandomlyPlayNormalDestorySound()
+void AMyPlayerController::PlayDestroySounds()
 {
-	const auto randNum = rand() % NUM_NORMAL_BLOCK_POP_SOUNDS;
-	if (normalBlockPopSounds[randNum] == nullptr)
-		return;
+	destroySoundAggregator.Flush(maxDestroySoundVoicesPerTick, destroySoundVoices);
+	// normal voices of a tick each take a different pop sound, starting from a random one
+	auto normalSoundIndex = rand() % NUM_NORMAL_BLOCK_POP_SOUNDS;
+	for (const auto& voice : destroySoundVoices) {
+		auto sound = specialBlockPopSound;
+		if (!voice.isSpecial) {
+			sound = normalBlockPopSounds[normalSoundIndex];
+			normalSoundIndex = (normalSoundIndex + 1) % NUM_NORMAL_BLOCK_POP_SOUNDS;
+		}
+		if (sound == nullptr)
+			continue;
 
-	UGameplayStatics::PlaySound2D(this, normalBlockPopSounds[randNum]);
+		UGameplayStatics::PlaySound2D(this, sound, voice.volumeMultiplier, voice.pitchMultiplier);
+	}
 }
 
-void AMyPlayerController::UpdateBlockStatus(AActor* pBlockActor, const PhysicalBlockSnapShot& physicalBlockSnapShot)
+void AMyPlayerController::UpdateBlockStatus(BlockViewTable::Slot& blockView, const PhysicalBlockSnapShot& physicalBlockSnapShot)
 {
-	if (pBlockActor == nullptr)
+	if (blockView.actor == nullptr)
 		return;
 
-	auto originalActionType = idToActionTypeMap.FindRef(physicalBlockSnapShot.id);
+	auto originalActionType = blockView.actionType;
 	auto justStartedGettingDestroyed = (physicalBlockSnapShot.actionType == ActionType::GetsDestroyed) && (originalActionType != ActionType::GetsDestroyed);
 	auto justEndedGettingDestroyed = (physicalBlockSnapShot.actionType != ActionType::GetsDestroyed) && (originalActionType == ActionType::GetsDestroyed);
 	if (justStartedGettingDestroyed || justEndedGettingDestroyed) {
-		DeleteBlockActor(physicalBlockSnapShot.id);
+		// swaps the block's actor for one of the other kind from the pool
+		DeleteBlockActor(blockView);
 		SpawnBlockActor(physicalBlockSnapShot);
+		return;
 	}
-	else {
-		pBlockActor->SetActorLocation(CellCoordinaeToWorldPosition(physicalBlockSnapShot.position));
-	}
-	idToActionTypeMap.Emplace(physicalBlockSnapShot.id, physicalBlockSnapShot.actionType);
+	const auto blockPosition = CellCoordinaeToWorldPosition(physicalBlockSnapShot.position);
+	blockView.actor->SetActorLocation(blockPosition);
+	ShowDecorator(physicalBlockSnapShot, blockPosition);
+	blockView.actionType = physicalBlockSnapShot.actionType;
 }
 
 void AMyPlayerController::UpdateBlocks()
 {
+	BLOCK_PHYSICS_SCOPED_STAT(UpdateBlockActors);
 	if (blockPhysics == nullptr)
 		return;
+	if (useInstancedBlockRendering && !instancedRenderer.IsInitialized())
+		return;
 
-	auto notUpdatedBlockIds = TSet<int>();
-	for (const auto& idAndBlockActor : idToBlockActorMap) {
-		notUpdatedBlockIds.Add(idAndBlockActor.Key);
-	}
+	// Idle blocks don't show up in the delta, so they cost nothing here.
+	const auto& delta = blockPhysics->GetPublishedDelta();
+	destroySoundAggregator.Gather(delta);
+	PlayDestroySounds();
+	blockViews.MarkDirty(delta);
+	if (useInstancedBlockRendering)
+		blockViews.ForEachDirty([this](BlockViewTable::Slot& blockView) { UpdateInstancedBlock(blockView); });
+	else
+		blockViews.ForEachDirty([this](BlockViewTable::Slot& blockView) { UpdateBlockActor(blockView); });
+	instancedRenderer.Flush();
+}
 
-	const auto physicalBlockSnapShots = blockPhysics->GetPhysicalBlockSnapShots();
-	for (const auto& physicalBlockSnapShot : physicalBlockSnapShots) {
-		const auto ppBlockActor = idToBlockActorMap.Find(physicalBlockSnapShot.id);
-		if (ppBlockActor == nullptr) {
-			SpawnBlockActor(physicalBlockSnapShot);
-		}
-		else if (ppBlockActor != nullptr){
-			PlayDestroySoundIfNeeded(physicalBlockSnapShot);
-			UpdateBlockStatus(*ppBlockActor, physicalBlockSnapShot);
-			notUpdatedBlockIds.Remove(physicalBlockSnapShot.id);
-		}
+void AMyPlayerController::UpdateBlockActor(BlockViewTable::Slot& blockView)
+{
+	if (blockView.IsDirty(BlockViewTable::Removed))
+		DeleteBlockActor(blockView);
+	if (blockView.pending == nullptr)
+		return;
+	const auto& physicalBlockSnapShot = *blockView.pending;
+	// a block changed without an actor is one whose actor failed to spawn
+	if (blockView.handle != physicalBlockSnapShot.handle) {
+		SpawnBlockActor(physicalBlockSnapShot);
+		return;
 	}
+	UpdateBlockStatus(blockView, physicalBlockSnapShot);
+}
+
+void AMyPlayerController::DeleteBlockActor(BlockViewTable::Slot& blockView)
+{
+	if (blockView.actor != nullptr)
+		blockActorPool.Release(blockView.actorKind, blockView.actor);
+	instancedRenderer.Hide(blockView.handle, BlockInstancedRenderer::Decorator);
+	blockView.Vacate();
+}
 
-	for (const auto blockId : notUpdatedBlockIds) {
-		DeleteBlockActor(blockId);
+void AMyPlayerController::InitializeInstancedRenderer()
+{
+	auto layerSprites = TArray<UPaperSprite*>();
+	layerSprites.SetNum(NUM_LAYERS);
+	for (int i = 0; i < NUM_NORMAL_BLOCK_TYPES; i++) {
+		layerSprites[i] = blockSprites[i];
+	}
+	for (int i = 0; i < NUM_SPECIAL_BLOCK_TYPES; i++) {
+		layerSprites[FIRST_SPECIAL_LAYER + i] = specialBlockSprites[i];
 	}
+	layerSprites[EXPLOSION_LAYER] = explosionSprite;
+	// actors draw the blocks themselves, leaving only the ribbons to the renderer
+	if (!useInstancedBlockRendering)
+		layerSprites.Init(nullptr, NUM_LAYERS);
+	layerSprites[RIBBON_LAYER] = horizontalRibbonSprite;
+	instancedRenderer.Initialize(GetWorld(), layerSprites);
 }
 
-void AMyPlayerController::DeleteBlockActor(int blockId)
+void AMyPlayerController::ShowInstancedBlock(const PhysicalBlockSnapShot& physicalBlockSnapShot)
 {
-	const auto ppBlockActor = idToBlockActorMap.Find(blockId);
-	if (ppBlockActor == nullptr)
-		return;
+	const auto block = physicalBlockSnapShot.block;
+	const auto position = GetBlockWorldPosition(physicalBlockSnapShot);
+	const auto handle = physicalBlockSnapShot.handle;
+	auto bodyLayer = static_cast<int>(block.GetColor());
+	if (physicalBlockSnapShot.actionType == ActionType::GetsDestroyed)
+		bodyLayer = EXPLOSION_LAYER;
+	else if (block.IsSpecial() && !block.HasDecoratorAttribute())
+		bodyLayer = FIRST_SPECIAL_LAYER + (block.GetSpecialAttribute() == BlockSpecialAttribute::ONE_COLOR_CLEAR ? 1 : 0);
+	instancedRenderer.Show(handle, BlockInstancedRenderer::Body, bodyLayer, FTransform(position));
+	ShowDecorator(physicalBlockSnapShot, position);
+}
 
-	auto pBlock = *ppBlockActor;
-	if (pBlock == nullptr)
+void AMyPlayerController::ShowDecorator(const PhysicalBlockSnapShot& physicalBlockSnapShot, const FVector& blockPosition)
+{
+	if (!instancedRenderer.IsInitialized())
 		return;
+	const auto block = physicalBlockSnapShot.block;
+	const auto handle = physicalBlockSnapShot.handle;
+	if (physicalBlockSnapShot.actionType == ActionType::GetsDestroyed || !block.HasDecoratorAttribute()) {
+		instancedRenderer.Hide(handle, BlockInstancedRenderer::Decorator);
+		return;
+	}
+	// just in front of the block, rotated by the decorator
+	const auto ribbonTransform = FTransform(GetDecoratorRotation(block.GetSpecialAttribute()), blockPosition + FVector(0, 0.5, 0), FVector(0.5, 1, 0.5));
+	instancedRenderer.Show(handle, BlockInstancedRenderer::Decorator, RIBBON_LAYER, ribbonTransform);
+}
 
-	pBlock->Destroy();
-	idToBlockActorMap.Remove(blockId);
-	idToActionTypeMap.Remove(blockId);
+void AMyPlayerController::UpdateInstancedBlock(BlockViewTable::Slot& blockView)
+{
+	if (blockView.IsDirty(BlockViewTable::Removed)) {
+		instancedRenderer.HideAll(blockView.handle);
+		blockView.Vacate();
+	}
+	if (blockView.pending == nullptr)
+		return;
+	const auto& physicalBlockSnapShot = *blockView.pending;
+	ShowInstancedBlock(physicalBlockSnapShot);
+	blockView.handle = physicalBlockSnapShot.handle;
+	blockView.actionType = physicalBlockSnapShot.actionType;
 }
 
 void AMyPlayerController::AddScore(int score)
@@ -338,12 +455,3 @@ void AMyPlayerController::AddScore(int score)
 	if (gameMode)
 		gameMode->score += score;
 }
-
-int AMyPlayerController::ComputeScore(const TSet<Match>& matches)
-{
-	auto ret = 0;
-	for (const auto& match : matches) {
-		ret += match.GetFormation().GetScore();
-	}
-	return ret;
-}
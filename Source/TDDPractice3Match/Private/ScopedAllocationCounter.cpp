@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ScopedAllocationCounter.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/UnrealMemory.h"
+
+namespace {
+	thread_local int32 numActiveCountersOnThisThread = 0;
+	thread_local uint64 numAllocationsOnThisThread = 0;
+	thread_local uint64 numAllocatedBytesOnThisThread = 0;
+
+	void CountAllocation(SIZE_T size)
+	{
+		if (numActiveCountersOnThisThread == 0)
+			return;
+		numAllocationsOnThisThread++;
+		numAllocatedBytesOnThisThread += size;
+	}
+
+	class CountingMalloc : public FMalloc {
+	public:
+		explicit CountingMalloc(FMalloc* innerMalloc) : innerMalloc(innerMalloc) {}
+
+		virtual void* Malloc(SIZE_T count, uint32 alignment) override
+		{
+			CountAllocation(count);
+			return innerMalloc->Malloc(count, alignment);
+		}
+		virtual void* Realloc(void* original, SIZE_T count, uint32 alignment) override
+		{
+			// shrinking or freeing through Realloc doesn't take new memory
+			if (original == nullptr || count > 0)
+				CountAllocation(count);
+			return innerMalloc->Realloc(original, count, alignment);
+		}
+		virtual void Free(void* original) override { innerMalloc->Free(original); }
+		virtual SIZE_T QuantizeSize(SIZE_T count, uint32 alignment) override { return innerMalloc->QuantizeSize(count, alignment); }
+		virtual bool GetAllocationSize(void* original, SIZE_T& sizeOut) override { return innerMalloc->GetAllocationSize(original, sizeOut); }
+		virtual void Trim(bool trimThreadCaches) override { innerMalloc->Trim(trimThreadCaches); }
+		virtual void SetupTLSCachesOnCurrentThread() override { innerMalloc->SetupTLSCachesOnCurrentThread(); }
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { innerMalloc->ClearAndDisableTLSCachesOnCurrentThread(); }
+		virtual void InitializeStatsMetadata() override { innerMalloc->InitializeStatsMetadata(); }
+		virtual void UpdateStats() override { innerMalloc->UpdateStats(); }
+		virtual void GetAllocatorStats(FGenericMemoryStats& outStats) override { innerMalloc->GetAllocatorStats(outStats); }
+		virtual void DumpAllocatorStats(FOutputDevice& ar) override { innerMalloc->DumpAllocatorStats(ar); }
+		virtual bool IsInternallyThreadSafe() const override { return innerMalloc->IsInternallyThreadSafe(); }
+		virtual bool ValidateHeap() override { return innerMalloc->ValidateHeap(); }
+		virtual const TCHAR* GetDescriptiveName() override { return innerMalloc->GetDescriptiveName(); }
+	private:
+		FMalloc* innerMalloc;
+	};
+
+	bool InstallCountingMallocOnce()
+	{
+		static const auto installed = [] {
+			if (GMalloc == nullptr)
+				return false;
+			// Intentionally leaked; memory allocated through the wrapper may be freed at any point until exit.
+			GMalloc = new CountingMalloc(GMalloc);
+			return true;
+		}();
+		return installed;
+	}
+}
+
+ScopedAllocationCounter::ScopedAllocationCounter()
+{
+	InstallCountingMallocOnce();
+	numActiveCountersOnThisThread++;
+	Restart();
+}
+
+ScopedAllocationCounter::~ScopedAllocationCounter()
+{
+	numActiveCountersOnThisThread--;
+}
+
+uint64 ScopedAllocationCounter::GetNumAllocations() const
+{
+	return numAllocationsOnThisThread - numAllocationsAtStart;
+}
+
+uint64 ScopedAllocationCounter::GetNumAllocatedBytes() const
+{
+	return numAllocatedBytesOnThisThread - numAllocatedBytesAtStart;
+}
+
+void ScopedAllocationCounter::Restart()
+{
+	numAllocationsAtStart = numAllocationsOnThisThread;
+	numAllocatedBytesAtStart = numAllocatedBytesOnThisThread;
+}
+
+bool ScopedAllocationCounter::IsCounting()
+{
+	return InstallCountingMallocOnce();
+}
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SpecialCombo.h"
+#include "ExplosionMask.h"
+
+namespace {
+	constexpr int NUM_ATTRIBUTES = static_cast<int>(BlockSpecialAttribute::INVALID) + 1;
+
+	// Symmetric combos center on the top, then left, of the two cells, so that either swipe direction clears the same cells.
+	FIntPoint GetTopLeft(FIntPoint cell1, FIntPoint cell2)
+	{
+		if (cell1.X != cell2.X)
+			return cell1.X < cell2.X ? cell1 : cell2;
+		return cell1.Y < cell2.Y ? cell1 : cell2;
+	}
+
+	void AddCross(ExplosionMask& explosionMask, FIntPoint firstCell, FIntPoint secondCell)
+	{
+		const auto center = GetTopLeft(firstCell, secondCell);
+		explosionMask.AddRow(center.X);
+		explosionMask.AddColumn(center.Y);
+	}
+
+	void AddWideCross(ExplosionMask& explosionMask, FIntPoint firstCell, FIntPoint secondCell)
+	{
+		const auto center = GetTopLeft(firstCell, secondCell);
+		for (int offset = -1; offset <= 1; offset++) {
+			explosionMask.AddRow(center.X + offset);
+			explosionMask.AddColumn(center.Y + offset);
+		}
+	}
+
+	void AddBigDiamond(ExplosionMask& explosionMask, FIntPoint firstCell, FIntPoint secondCell)
+	{
+		explosionMask.AddDiamond(GetTopLeft(firstCell, secondCell), 2 * Block::DIAMOND_CLEAR_RADIUS);
+	}
+
+	// The rollable rolls on away from the line clearer, clearing the line across every cell it passes.
+	void AddRollingLineClear(ExplosionMask& explosionMask, FIntPoint lineClearerCell, FIntPoint rollableCell)
+	{
+		const auto direction = rollableCell - lineClearerCell;
+		const auto isRollingVertically = direction.X != 0;
+		for (auto cell = lineClearerCell; (0 <= cell.X) && (cell.X < explosionMask.GetNumRows()) && (0 <= cell.Y) && (cell.Y < explosionMask.GetNumCols()); cell += direction) {
+			if (isRollingVertically)
+				explosionMask.AddRow(cell.X);
+			else
+				explosionMask.AddColumn(cell.Y);
+		}
+	}
+}
+
+const SpecialCombo& SpecialCombo::Find(BlockSpecialAttribute firstAttribute, BlockSpecialAttribute secondAttribute)
+{
+	class ComboTable {
+	public:
+		ComboTable()
+		{
+			const auto lineClearers = { BlockSpecialAttribute::VERTICAL_LINE_CLEAR, BlockSpecialAttribute::HORIZONTAL_LINE_CLEAR };
+			for (const auto lineClearer1 : lineClearers) {
+				for (const auto lineClearer2 : lineClearers) {
+					Register(lineClearer1, lineClearer2, SpecialComboType::Cross, &AddCross);
+				}
+				Register(lineClearer1, BlockSpecialAttribute::DIAMOND_NEIGHBORHOOD_CLEAR, SpecialComboType::WideCross, &AddWideCross);
+				Register(lineClearer1, BlockSpecialAttribute::ROLLABLE, SpecialComboType::RollingLineClear, &AddRollingLineClear);
+			}
+			Register(BlockSpecialAttribute::DIAMOND_NEIGHBORHOOD_CLEAR, BlockSpecialAttribute::DIAMOND_NEIGHBORHOOD_CLEAR, SpecialComboType::BigDiamond, &AddBigDiamond);
+			for (int attributeIndex = 0; attributeIndex < NUM_ATTRIBUTES; attributeIndex++) {
+				const auto attribute = static_cast<BlockSpecialAttribute>(attributeIndex);
+				if (attribute != BlockSpecialAttribute::INVALID)
+					Register(BlockSpecialAttribute::ONE_COLOR_CLEAR, attribute, SpecialComboType::OneColorClear, nullptr);
+			}
+		}
+		SpecialCombo combos[NUM_ATTRIBUTES][NUM_ATTRIBUTES];
+	private:
+		void Register(BlockSpecialAttribute attribute1, BlockSpecialAttribute attribute2, SpecialComboType type, EffectFunction effect)
+		{
+			auto& combo = combos[static_cast<int>(attribute1)][static_cast<int>(attribute2)];
+			combo.type = type;
+			combo.effect = effect;
+			combo.isMirrored = false;
+			if (attribute1 == attribute2)
+				return;
+			auto& mirroredCombo = combos[static_cast<int>(attribute2)][static_cast<int>(attribute1)];
+			mirroredCombo.type = type;
+			mirroredCombo.effect = effect;
+			mirroredCombo.isMirrored = true;
+		}
+	};
+	static const auto comboTable = ComboTable();
+	return comboTable.combos[static_cast<int>(firstAttribute)][static_cast<int>(secondAttribute)];
+}
+
+void SpecialCombo::AddEffectTo(ExplosionMask& explosionMask, FIntPoint firstCell, FIntPoint secondCell) const
+{
+	if (effect == nullptr)
+		return;
+	if (isMirrored)
+		effect(explosionMask, secondCell, firstCell);
+	else
+		effect(explosionMask, firstCell, secondCell);
+}
@@ -5,7 +5,14 @@
 #include "../Public/Block.h"
 #include "../Public/BlockPhysics.h"
 #include "Misc/AutomationTest.h"
+#include "HAL/PlatformTime.h"
 #include "../Public/BlockPhysicsTester.h"
+#include "../Public/BlockRandomGenerator.h"
+#include "../Public/BlockPhysicsTraceDecoder.h"
+#include "../Public/BlockPhysicsBot.h"
+#include "../Public/ExplosionMask.h"
+#include "../Public/BlockViewTable.h"
+#include "../Public/BlockDestroySoundAggregator.h"
 
 
 IMPLEMENT_SIMPLE_AUTOMATION_TEST(HasNoMatchShouldReturnTrueGivenNoMatch, "Blocks.BlockMatrix.HasNoMatch should return true when no match", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
@@ -288,6 +295,29 @@ bool SwipeOnMunchickenShouldRollItForFrequentTick::RunTest(const FString& Parame
 	return true;
 }
 
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(MunchickenShouldNotTunnelPastCellsInALongTick, "Board.Rollable.Rollable should roll over every cell it passes in a long tick", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool MunchickenShouldNotTunnelPastCellsInALongTick::RunTest(const FString& Parameters) {
+	const auto swipeStart = FIntPoint{ 2, 2 };
+	const auto swipeEnd = FIntPoint{ 2, 1 };
+	auto blockPhysics = BlockPhysics(TestUtils::munchickenRollTest);
+	blockPhysics.DisableTickDebugLog();
+	blockPhysics.ReceiveSwipeInput(swipeStart, swipeEnd);
+	// past the edge of the board in one tick
+	blockPhysics.Tick(10 * BlockPhysics::GRID_SIZE / BlockPhysics::ROLL_SPEED);
+
+	auto numRolledOverBlocks = 0;
+	for (const auto& snapshot : blockPhysics.GetPhysicalBlockSnapShots()) {
+		if (BlockPhysics::ToFIntPoint(snapshot.position).X != swipeStart.X || snapshot.block != Block::ONE)
+			continue;
+		if (snapshot.actionType != ActionType::GetsDestroyed)
+			UE_LOG(LogTemp, Error, TEXT("Block at (%f, %f) should be rolled over"), snapshot.position.X, snapshot.position.Y);
+		numRolledOverBlocks++;
+	}
+	if (numRolledOverBlocks != 2)
+		UE_LOG(LogTemp, Error, TEXT("Expected 2 rolled over blocks, found %d"), numRolledOverBlocks);
+	return true;
+}
+
 IMPLEMENT_SIMPLE_AUTOMATION_TEST(MunchickenVerticalRollShouldNotSpawnNewBlocks, "Board.Rollable.Rollable vertical roll should not spawn new blocks", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
 bool MunchickenVerticalRollShouldNotSpawnNewBlocks::RunTest(const FString& Parameters) {
 
@@ -462,6 +492,234 @@ bool LineClearerShouldClearALineOnDestroy::RunTest(const FString& Parameters) {
 	return true;
 }
 
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(OneByFiveMatchShouldSpawnOneColorClear, "Board.MatchRule.One color clear should be generated if 1x5 matched", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool OneByFiveMatchShouldSpawnOneColorClear::RunTest(const FString& Parameters) {
+
+	const auto swipeStart = FIntPoint{ 1, 2 };
+	const auto swipeEnd = FIntPoint{ 0, 2 };
+	auto blockMatrix = BlockMatrix(TArray<TArray<Block>>{
+		{ Block::ZERO, Block::ZERO, Block::ONE, Block::ZERO, Block::ZERO },
+		{ Block::TWO, Block::THREE, Block::ZERO, Block::FOUR, Block::TWO }
+	});
+	auto counter = 0;
+	const auto newBlockGenerator = [&counter]() -> int {
+		return counter++;
+	};
+	auto blockPhysicsTester = BlockPhysicsTester(blockMatrix, newBlockGenerator);
+
+	blockPhysicsTester.DoSwipe(swipeStart, swipeEnd);
+	blockPhysicsTester.TickUntilSwipeMoveAnimationEnd();
+	blockPhysicsTester.TickUntilBlockDestroyEnd();
+	const auto expectedOneColorClearBlock = Block(BlockColor::NONE, BlockSpecialAttribute::ONE_COLOR_CLEAR);
+	blockPhysicsTester.TestIfBlockExistsAt(expectedOneColorClearBlock, swipeEnd);
+	blockPhysicsTester.TestBlockOccurrence(expectedOneColorClearBlock, 1);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(LShapeMatchShouldSpawnDiamondClear, "Board.MatchRule.Diamond clearer should be generated if L shape matched", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool LShapeMatchShouldSpawnDiamondClear::RunTest(const FString& Parameters) {
+
+	const auto swipeStart = FIntPoint{ 0, 1 };
+	const auto swipeEnd = FIntPoint{ 1, 1 };
+	auto blockMatrix = BlockMatrix(TArray<TArray<Block>>{
+		{ Block::ONE, Block::ZERO, Block::TWO, Block::THREE },
+		{ Block::TWO, Block::FOUR, Block::ZERO, Block::ZERO },
+		{ Block::THREE, Block::ZERO, Block::ONE, Block::TWO },
+		{ Block::ONE, Block::ZERO, Block::THREE, Block::FOUR }
+	});
+	auto counter = 0;
+	const auto newBlockGenerator = [&counter]() -> int {
+		return counter++;
+	};
+	auto blockPhysicsTester = BlockPhysicsTester(blockMatrix, newBlockGenerator);
+
+	blockPhysicsTester.DoSwipe(swipeStart, swipeEnd);
+	blockPhysicsTester.TickUntilSwipeMoveAnimationEnd();
+	blockPhysicsTester.TickUntilBlockDestroyEnd();
+	const auto expectedDiamondClearBlock = Block(BlockColor::ZERO, BlockSpecialAttribute::DIAMOND_NEIGHBORHOOD_CLEAR);
+	blockPhysicsTester.TestIfBlockExistsAt(expectedDiamondClearBlock, swipeEnd);
+	blockPhysicsTester.TestBlockOccurrence(expectedDiamondClearBlock, 1);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(DiamondClearShouldClearItsDiamondOnDestroy, "Board.DiamondClear.Diamond clearer should clear the diamond around it, clipped at the board edge", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool DiamondClearShouldClearItsDiamondOnDestroy::RunTest(const FString& Parameters) {
+
+	const auto swipeStart = FIntPoint{ 1, 2 };
+	const auto swipeEnd = FIntPoint{ 0, 2 };
+	auto blockMatrix = BlockMatrix(TArray<TArray<Block>>{
+		{ Block(BlockColor::ONE, BlockSpecialAttribute::DIAMOND_NEIGHBORHOOD_CLEAR), Block::ONE, Block::TWO, Block::THREE },
+		{ Block::TWO, Block::THREE, Block::ONE, Block::FOUR },
+		{ Block::THREE, Block::FOUR, Block::TWO, Block::ZERO },
+		{ Block::ZERO, Block::TWO, Block::THREE, Block::FOUR }
+	});
+	auto blockPhysicsTester = BlockPhysicsTester(blockMatrix);
+
+	blockPhysicsTester.DoSwipe(swipeStart, swipeEnd);
+	blockPhysicsTester.TickUntilSwipeMoveAnimationEnd();
+	const auto blockDestroyExpectedPositions = TSet<FIntPoint>{
+		{0,0}, {0,1}, {0,2},
+		{1,0}, {1,1},
+		{2,0}
+	};
+	blockPhysicsTester.TestIfCorrectlyGettingDestroyed(blockDestroyExpectedPositions);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(DiamondClearShouldClearFallingBlocksInItsDiamond, "Board.DiamondClear.Diamond clearer should clear the blocks falling through its diamond", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool DiamondClearShouldClearFallingBlocksInItsDiamond::RunTest(const FString& Parameters) {
+	const auto diamondCenter = FIntPoint{ 2, 1 };
+	auto blockPhysics = BlockPhysics(BlockMatrix(TArray<TArray<Block>>{
+		{ Block::THREE, Block::TWO, Block::FOUR, Block::THREE },
+		{ Block::FOUR, Block::THREE, Block::TWO, Block::FOUR },
+		{ Block::ONE, Block(BlockColor::ZERO, BlockSpecialAttribute::DIAMOND_NEIGHBORHOOD_CLEAR), Block::ZERO, Block::ONE },
+		{ Block::ONE, Block::FOUR, Block::THREE, Block::ZERO },
+		{ Block::TWO, Block::ONE, Block::FOUR, Block::THREE }
+	}));
+	blockPhysics.DisableTickDebugLog();
+	// Clears the bottom of column 0, so that the two blocks above fall through the diamond's left side.
+	blockPhysics.ReceiveSwipeInput(FIntPoint{ 4, 1 }, FIntPoint{ 4, 0 });
+	for (int i = 0; i < 14; i++) {
+		blockPhysics.Tick(0.05f);
+	}
+	// Sets the diamond off in row 2 while they are still falling.
+	blockPhysics.ReceiveSwipeInput(FIntPoint{ 3, 3 }, FIntPoint{ 2, 3 });
+	const auto isInDiamond = [&diamondCenter](FIntPoint cell) {
+		return FMath::Abs(cell.X - diamondCenter.X) + FMath::Abs(cell.Y - diamondCenter.Y) <= Block::DIAMOND_CLEAR_RADIUS;
+	};
+	for (int i = 0; i < 20; i++) {
+		auto fallingHandles = TSet<BlockHandle>();
+		for (const auto& snapShot : blockPhysics.GetPublishedSnapShots()) {
+			if (snapShot.actionType == ActionType::Fall)
+				fallingHandles.Add(snapShot.handle);
+		}
+		blockPhysics.Tick(0.05f);
+		const auto snapShots = blockPhysics.GetPublishedSnapShots();
+		auto diamondSetOff = false;
+		for (const auto& snapShot : snapShots) {
+			if (snapShot.block.GetSpecialAttribute() == BlockSpecialAttribute::DIAMOND_NEIGHBORHOOD_CLEAR && snapShot.actionType == ActionType::GetsDestroyed)
+				diamondSetOff = true;
+		}
+		if (!diamondSetOff)
+			continue;
+
+		auto numFallingBlocksHit = 0;
+		for (const auto& snapShot : snapShots) {
+			const auto cell = BlockPhysics::ToFIntPoint(snapShot.position);
+			if (!isInDiamond(cell) || cell.X < 0)
+				continue;
+			if (snapShot.actionType != ActionType::GetsDestroyed)
+				UE_LOG(LogTemp, Error, TEXT("The block at (%d, %d) is in the diamond but survived"), cell.X, cell.Y);
+			else if (fallingHandles.Contains(snapShot.handle))
+				numFallingBlocksHit++;
+		}
+		if (numFallingBlocksHit == 0)
+			UE_LOG(LogTemp, Error, TEXT("The diamond should have caught a block falling through it"));
+		return true;
+	}
+	UE_LOG(LogTemp, Error, TEXT("The diamond should have been set off"));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(OneColorClearShouldClearTheColorSwipedWith, "Board.OneColorClear.One color clear should clear the color it is swiped with", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool OneColorClearShouldClearTheColorSwipedWith::RunTest(const FString& Parameters) {
+
+	const auto swipeStart = FIntPoint{ 1, 0 };
+	const auto swipeEnd = FIntPoint{ 1, 1 };
+	const auto oneColorClear = Block(BlockColor::NONE, BlockSpecialAttribute::ONE_COLOR_CLEAR);
+	auto blockMatrix = BlockMatrix(TArray<TArray<Block>>{
+		{ Block::ONE, Block::TWO, Block::THREE },
+		{ oneColorClear, Block::ONE, Block::FOUR },
+		{ Block::TWO, Block::THREE, Block(BlockColor::ONE, BlockSpecialAttribute::HORIZONTAL_LINE_CLEAR) }
+	});
+	auto blockPhysicsTester = BlockPhysicsTester(blockMatrix);
+
+	blockPhysicsTester.DoSwipe(swipeStart, swipeEnd);
+	blockPhysicsTester.TickUntilSwipeMoveAnimationEnd();
+	// Every ONE block goes, and the line clearer among them clears its row.
+	const auto blockDestroyExpectedPositions = TSet<FIntPoint>{
+		{0,0},
+		{1,0}, {1,1},
+		{2,0}, {2,1}, {2,2}
+	};
+	blockPhysicsTester.TestIfCorrectlyGettingDestroyed(blockDestroyExpectedPositions);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(OneColorClearsSwipedTogetherShouldClearTwoColors, "Board.OneColorClear.One color clears swiped together should clear the two most common colors", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool OneColorClearsSwipedTogetherShouldClearTwoColors::RunTest(const FString& Parameters) {
+
+	const auto swipeStart = FIntPoint{ 1, 0 };
+	const auto swipeEnd = FIntPoint{ 1, 1 };
+	const auto oneColorClear = Block(BlockColor::NONE, BlockSpecialAttribute::ONE_COLOR_CLEAR);
+	auto blockMatrix = BlockMatrix(TArray<TArray<Block>>{
+		{ Block::ONE, Block::TWO, Block::ONE },
+		{ oneColorClear, oneColorClear, Block::TWO },
+		{ Block::THREE, Block::TWO, Block::ONE }
+	});
+	auto blockPhysicsTester = BlockPhysicsTester(blockMatrix);
+
+	blockPhysicsTester.DoSwipe(swipeStart, swipeEnd);
+	blockPhysicsTester.TickUntilSwipeMoveAnimationEnd();
+	const auto blockDestroyExpectedPositions = TSet<FIntPoint>{
+		{0,0}, {0,1}, {0,2},
+		{1,0}, {1,1}, {1,2},
+		{2,1}, {2,2}
+	};
+	blockPhysicsTester.TestIfCorrectlyGettingDestroyed(blockDestroyExpectedPositions);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(SwappedLineClearersShouldClearACross, "Board.SpecialCombo.Swapped line clearers should clear a cross instead of their own lines", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool SwappedLineClearersShouldClearACross::RunTest(const FString& Parameters) {
+
+	const auto swipeStart = FIntPoint{ 2, 1 };
+	const auto swipeEnd = FIntPoint{ 2, 2 };
+	auto blockMatrix = BlockMatrix(TArray<TArray<Block>>{
+		{ Block::ZERO, Block::ONE, Block::TWO, Block::THREE, Block::FOUR },
+		{ Block::TWO, Block::THREE, Block::FOUR, Block::ZERO, Block::ONE },
+		{ Block::FOUR, Block(BlockColor::ZERO, BlockSpecialAttribute::VERTICAL_LINE_CLEAR), Block(BlockColor::ONE, BlockSpecialAttribute::HORIZONTAL_LINE_CLEAR), Block::TWO, Block::THREE },
+		{ Block::ONE, Block::TWO, Block::THREE, Block::FOUR, Block::ZERO },
+		{ Block::THREE, Block::FOUR, Block::ZERO, Block::ONE, Block::TWO }
+	});
+	auto blockPhysicsTester = BlockPhysicsTester(blockMatrix);
+
+	blockPhysicsTester.DoSwipe(swipeStart, swipeEnd);
+	blockPhysicsTester.TickUntilSwipeMoveAnimationEnd();
+	const auto blockDestroyExpectedPositions = TSet<FIntPoint>{
+		{0,1}, {1,1}, {3,1}, {4,1},
+		{2,0}, {2,1}, {2,2}, {2,3}, {2,4}
+	};
+	blockPhysicsTester.TestIfCorrectlyGettingDestroyed(blockDestroyExpectedPositions);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(MunchickenSwappedWithLineClearerShouldRollALineClear, "Board.SpecialCombo.Rollable swapped with a line clearer should clear lines along its roll", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool MunchickenSwappedWithLineClearerShouldRollALineClear::RunTest(const FString& Parameters) {
+
+	const auto swipeStart = FIntPoint{ 2, 2 };
+	const auto swipeEnd = FIntPoint{ 2, 1 };
+	auto blockMatrix = BlockMatrix(TArray<TArray<Block>>{
+		{ Block::ZERO, Block::ONE, Block::TWO, Block::THREE, Block::FOUR },
+		{ Block::TWO, Block::THREE, Block::FOUR, Block::ZERO, Block::ONE },
+		{ Block::FOUR, Block(BlockColor::ZERO, BlockSpecialAttribute::HORIZONTAL_LINE_CLEAR), Block::MUNCHICKEN, Block::TWO, Block::THREE },
+		{ Block::ONE, Block::TWO, Block::THREE, Block::FOUR, Block::ZERO },
+		{ Block::THREE, Block::FOUR, Block::ZERO, Block::ONE, Block::TWO }
+	});
+	auto blockPhysicsTester = BlockPhysicsTester(blockMatrix);
+
+	blockPhysicsTester.DoSwipe(swipeStart, swipeEnd);
+	blockPhysicsTester.TickUntilSwipeMoveAnimationEnd();
+	// The munchicken ends up left of the line clearer, so every column from the line clearer's to the left edge goes.
+	auto blockDestroyExpectedPositions = TSet<FIntPoint>();
+	for (int row = 0; row < 5; row++) {
+		for (int col = 0; col <= 2; col++) {
+			blockDestroyExpectedPositions.Add(FIntPoint{ row, col });
+		}
+	}
+	blockPhysicsTester.TestIfCorrectlyGettingDestroyed(blockDestroyExpectedPositions);
+	return true;
+}
 
 IMPLEMENT_SIMPLE_AUTOMATION_TEST(OnlyOneSpecialBlockShouldBeGeneratedEvenIfManyCandidatePositions, "Board.MatchRule.Only one special block should be generated even if candidate positions are many", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
 bool OnlyOneSpecialBlockShouldBeGeneratedEvenIfManyCandidatePositions::RunTest(const FString& Parameters) {
@@ -502,4 +760,599 @@ bool BlockPhysicsShouldReturnInActionWhenBlockMoving::RunTest(const FString& Par
 	blockPhysicsTester.TickUntilSwipeReturnAnimtaionEnd();
 	blockPhysicsTester.TestIsInAction(false);
 	return true;
-}
\ No newline at end of file
+}
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(RestoredRandomStateShouldRepeatSequence, "Random.BlockRandomGenerator.Restored state should repeat the same sequence", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool RestoredRandomStateShouldRepeatSequence::RunTest(const FString& Parameters) {
+	auto randomGenerator = BlockRandomGenerator(1234);
+	const auto snapshot = randomGenerator.GetState();
+	auto firstSequence = TArray<int32>();
+	randomGenerator.FillInRange(validColors.Num(), 64, firstSequence);
+	randomGenerator.SetState(snapshot);
+	auto secondSequence = TArray<int32>();
+	randomGenerator.FillInRange(validColors.Num(), 64, secondSequence);
+	for (const auto value : firstSequence) {
+		if (value < 0 || value >= validColors.Num())
+			UE_LOG(LogTemp, Error, TEXT("Random value %d is out of range [0, %d)"), value, validColors.Num());
+	}
+	return firstSequence == secondSequence;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(SameSeedShouldRefillSameBlocks, "Board.BlockSpawn.Boards with the same seed should refill the same blocks", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool SameSeedShouldRefillSameBlocks::RunTest(const FString& Parameters) {
+	const auto seed = uint64(42);
+	auto blockPhysics1 = BlockPhysics(TestUtils::blockMatrix5x5, seed);
+	auto blockPhysics2 = BlockPhysics(TestUtils::blockMatrix5x5, seed);
+	blockPhysics1.DisableTickDebugLog();
+	blockPhysics2.DisableTickDebugLog();
+	for (auto* blockPhysics : { &blockPhysics1, &blockPhysics2 }) {
+		blockPhysics->ReceiveSwipeInput(FIntPoint{ 0, 3 }, FIntPoint{ 0, 2 });
+		for (int i = 0; i < 120; i++)
+			blockPhysics->Tick(1.f / 60.f);
+	}
+	const auto snapshots1 = blockPhysics1.GetPhysicalBlockSnapShots();
+	const auto snapshots2 = blockPhysics2.GetPhysicalBlockSnapShots();
+	if (snapshots1.Num() != snapshots2.Num())
+		return false;
+	for (int i = 0; i < snapshots1.Num(); i++) {
+		if (snapshots1[i].block != snapshots2[i].block || snapshots1[i].position != snapshots2[i].position) {
+			UE_LOG(LogTemp, Error, TEXT("Boards with the same seed diverged at snapshot %d"), i);
+			return false;
+		}
+	}
+	return blockPhysics1.GetRandomState() == blockPhysics2.GetRandomState();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(BlockHandlesShouldSurviveRemovalOfOtherBlocks, "Board.Handles.Block handles should survive removal of other blocks", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool BlockHandlesShouldSurviveRemovalOfOtherBlocks::RunTest(const FString& Parameters) {
+	auto blockPhysics = BlockPhysics(TestUtils::blockMatrix5x5);
+	blockPhysics.DisableTickDebugLog();
+	const auto untouchedPosition = FIntPoint{ 4, 4 };
+	const auto matchedPosition = FIntPoint{ 0, 0 };
+	const auto untouchedHandle = blockPhysics.GetTopmostBlockSnapShotAt(untouchedPosition).handle;
+	const auto matchedHandle = blockPhysics.GetTopmostBlockSnapShotAt(matchedPosition).handle;
+
+	blockPhysics.ReceiveSwipeInput(FIntPoint{ 0, 3 }, FIntPoint{ 0, 2 });
+	for (int i = 0; i < 120; i++)
+		blockPhysics.Tick(1.f / 60.f);
+
+	if (blockPhysics.GetTopmostBlockSnapShotAt(untouchedPosition).handle != untouchedHandle)
+		UE_LOG(LogTemp, Error, TEXT("Handle of the block at (%d, %d) changed"), untouchedPosition.X, untouchedPosition.Y);
+	if (blockPhysics.GetBlockSnapShot(untouchedHandle).position != FVector2D(untouchedPosition))
+		UE_LOG(LogTemp, Error, TEXT("Handle lookup did not find the block at (%d, %d)"), untouchedPosition.X, untouchedPosition.Y);
+	if (blockPhysics.GetBlockSnapShot(matchedHandle).handle.IsValid())
+		UE_LOG(LogTemp, Error, TEXT("Handle of a removed block should be stale"));
+	return true;
+}
+
+#if BLOCK_PHYSICS_TRACE_ENABLED
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(TraceShouldRecordMatchedBlockDestruction, "Board.Trace.Trace should record destruction of matched blocks", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool TraceShouldRecordMatchedBlockDestruction::RunTest(const FString& Parameters) {
+	auto blockPhysics = BlockPhysics(TestUtils::blockMatrix5x5);
+	blockPhysics.DisableTickDebugLog();
+	blockPhysics.ReceiveSwipeInput(FIntPoint{ 0, 3 }, FIntPoint{ 0, 2 });
+	for (int i = 0; i < 120; i++)
+		blockPhysics.Tick(1.f / 60.f);
+
+	auto records = TArray<BlockTraceRecord>();
+	blockPhysics.GetTrace()->CopyRecords(records);
+	auto numDestroyStarted = 0;
+	for (const auto& record : records) {
+		if (record.eventType == BlockTraceEventType::MatchedBlockDestroyStarted)
+			numDestroyStarted++;
+	}
+	if (numDestroyStarted != 3)
+		UE_LOG(LogTemp, Error, TEXT("Expected 3 matched blocks to start getting destroyed but there were %d"), numDestroyStarted);
+	if (!BlockPhysicsTraceDecoder::ToText(records[0]).Contains(TEXT("TickStart")))
+		UE_LOG(LogTemp, Error, TEXT("First trace record should decode to a tick start"));
+	return true;
+}
+#endif
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(SettledBoardShouldNotAllocate, "Board.Allocation.Settled board should not allocate while ticking", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool SettledBoardShouldNotAllocate::RunTest(const FString& Parameters) {
+	auto blockPhysicsTester = BlockPhysicsTester(TestUtils::blockMatrix5x5);
+	blockPhysicsTester.SetTickDivider(10);
+	blockPhysicsTester.TickUntilSwipeMoveAnimationEnd();
+	blockPhysicsTester.StartTrackingAllocations();
+	blockPhysicsTester.TickUntilBlockDestroyEnd();
+	blockPhysicsTester.TestAllocationsPerTickWithin(0, 0);
+	blockPhysicsTester.TestGetMatchesAllocationsWithin(0, 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(SwipeShouldStayWithinAllocationBudget, "Board.Allocation.Swipe without a match should stay within the allocation budget", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool SwipeShouldStayWithinAllocationBudget::RunTest(const FString& Parameters) {
+	const auto maxAllocationsPerTick = uint64(64);
+	const auto maxAllocatedBytesPerTick = uint64(16 * 1024);
+	auto blockPhysicsTester = BlockPhysicsTester(TestUtils::blockMatrix5x5);
+	blockPhysicsTester.SetTickDivider(10);
+	blockPhysicsTester.StartTrackingAllocations();
+	blockPhysicsTester.DoSwipe(FIntPoint{ 1, 2 }, FIntPoint{ 1, 3 });
+	blockPhysicsTester.TickUntilSwipeMoveAnimationEnd();
+	blockPhysicsTester.TickUntilSwipeReturnAnimtaionEnd();
+	blockPhysicsTester.TestAllocationsPerTickWithin(maxAllocationsPerTick, maxAllocatedBytesPerTick);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(CascadeShouldStayWithinAllocationBudget, "Board.Allocation.Cascade should stay within the allocation budget", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool CascadeShouldStayWithinAllocationBudget::RunTest(const FString& Parameters) {
+	const auto maxAllocationsPerTick = uint64(160);
+	const auto maxAllocatedBytesPerTick = uint64(32 * 1024);
+	auto blockPhysicsTester = BlockPhysicsTester(TestUtils::blockMatrix5x5);
+	blockPhysicsTester.SetTickDivider(10);
+	blockPhysicsTester.StartTrackingAllocations();
+	blockPhysicsTester.DoSwipe(FIntPoint{ 0, 3 }, FIntPoint{ 0, 2 });
+	blockPhysicsTester.TickUntilSwipeMoveAnimationEnd();
+	blockPhysicsTester.TickUntilBlockDestroyEnd();
+	blockPhysicsTester.TickUntilBlockFallEnd(1);
+	blockPhysicsTester.TestAllocationsPerTickWithin(maxAllocationsPerTick, maxAllocatedBytesPerTick);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(PublishedSnapShotsShouldFollowTicks, "Board.Getters.Published snapshots should follow ticks without being overwritten early", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool PublishedSnapShotsShouldFollowTicks::RunTest(const FString& Parameters) {
+	auto blockPhysics = BlockPhysics(TestUtils::blockMatrix5x5);
+	blockPhysics.DisableTickDebugLog();
+	blockPhysics.ReceiveSwipeInput(FIntPoint{ 0, 3 }, FIntPoint{ 0, 2 });
+	blockPhysics.Tick(0.1f);
+	const auto previousView = blockPhysics.GetPublishedSnapShots();
+	const auto movingBlockIndex = previousView.IndexOfByPredicate([](const PhysicalBlockSnapShot& snapshot) {
+		return snapshot.actionType == ActionType::SwipeMove;
+	});
+	if (movingBlockIndex == INDEX_NONE)
+		return false;
+	const auto previousPosition = previousView[movingBlockIndex].position;
+	blockPhysics.Tick(0.1f);
+	if (previousView[movingBlockIndex].position != previousPosition)
+		UE_LOG(LogTemp, Error, TEXT("The view published by the previous tick was overwritten"));
+
+	const auto liveSnapShots = blockPhysics.GetPhysicalBlockSnapShots();
+	const auto publishedSnapShots = blockPhysics.GetPublishedSnapShots();
+	if (liveSnapShots.Num() != publishedSnapShots.Num())
+		return false;
+	for (int i = 0; i < liveSnapShots.Num(); i++) {
+		if (liveSnapShots[i].handle != publishedSnapShots[i].handle || liveSnapShots[i].position != publishedSnapShots[i].position)
+			UE_LOG(LogTemp, Error, TEXT("Published snapshot %d differs from the live state"), i);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(PublishedDeltaShouldReproduceSnapShots, "Board.Getters.Applying published deltas should reproduce the published snapshots", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool PublishedDeltaShouldReproduceSnapShots::RunTest(const FString& Parameters) {
+	auto blockPhysics = BlockPhysics(TestUtils::blockMatrix5x5);
+	blockPhysics.DisableTickDebugLog();
+	auto mirroredSnapShots = TMap<BlockHandle, PhysicalBlockSnapShot>();
+	for (const auto& snapShot : blockPhysics.GetPublishedSnapShots()) {
+		mirroredSnapShots.Add(snapShot.handle, snapShot);
+	}
+	blockPhysics.Tick(0.1f);
+	if (!blockPhysics.GetPublishedDelta().IsEmpty())
+		UE_LOG(LogTemp, Error, TEXT("A settled board should publish an empty delta"));
+
+	blockPhysics.ReceiveSwipeInput(FIntPoint{ 0, 3 }, FIntPoint{ 0, 2 });
+	auto numRemovedBlocks = 0;
+	for (int i = 0; i < 60; i++) {
+		blockPhysics.Tick(0.1f);
+		const auto& delta = blockPhysics.GetPublishedDelta();
+		numRemovedBlocks += delta.removed.Num();
+		for (const auto blockHandle : delta.removed) {
+			if (mirroredSnapShots.Remove(blockHandle) == 0)
+				UE_LOG(LogTemp, Error, TEXT("Removed a block that was never published"));
+		}
+		for (const auto& snapShot : delta.spawned) {
+			mirroredSnapShots.Add(snapShot.handle, snapShot);
+		}
+		for (const auto& snapShot : delta.changed) {
+			if (mirroredSnapShots.Find(snapShot.handle) == nullptr)
+				UE_LOG(LogTemp, Error, TEXT("Changed a block that was never published"));
+			mirroredSnapShots.Add(snapShot.handle, snapShot);
+		}
+
+		const auto publishedSnapShots = blockPhysics.GetPublishedSnapShots();
+		if (mirroredSnapShots.Num() != publishedSnapShots.Num()) {
+			UE_LOG(LogTemp, Error, TEXT("Tick %d: mirrored %d blocks but %d are published"), i, mirroredSnapShots.Num(), publishedSnapShots.Num());
+			return false;
+		}
+		for (const auto& snapShot : publishedSnapShots) {
+			const auto* mirroredSnapShot = mirroredSnapShots.Find(snapShot.handle);
+			if (mirroredSnapShot == nullptr || !(mirroredSnapShot->block == snapShot.block) || mirroredSnapShot->actionType != snapShot.actionType || mirroredSnapShot->position != snapShot.position)
+				UE_LOG(LogTemp, Error, TEXT("Tick %d: the mirrored snapshot of block %d is out of date"), i, snapShot.handle.GetIndex());
+		}
+	}
+	if (numRemovedBlocks == 0)
+		UE_LOG(LogTemp, Error, TEXT("The swipe should have removed matched blocks"));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(BlockViewsShouldFollowPublishedDeltas, "Board.Getters.Block views reconciled from published deltas should match the published snapshots", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool BlockViewsShouldFollowPublishedDeltas::RunTest(const FString& Parameters) {
+	auto blockPhysics = BlockPhysics(TestUtils::blockMatrix5x5);
+	blockPhysics.DisableTickDebugLog();
+	auto blockViews = BlockViewTable();
+	for (const auto& snapShot : blockPhysics.GetPublishedSnapShots()) {
+		blockViews.Occupy(snapShot.handle).actionType = snapShot.actionType;
+	}
+
+	blockPhysics.ReceiveSwipeInput(FIntPoint{ 0, 3 }, FIntPoint{ 0, 2 });
+	auto removedHandles = TArray<BlockHandle>();
+	for (int i = 0; i < 60; i++) {
+		blockPhysics.Tick(0.1f);
+		const auto& delta = blockPhysics.GetPublishedDelta();
+		removedHandles.Append(delta.removed);
+		blockViews.MarkDirty(delta);
+		auto lastSlotIndex = INDEX_NONE;
+		blockViews.ForEachDirty([&](BlockViewTable::Slot& blockView) {
+			if (blockView.IsDirty(BlockViewTable::Removed))
+				blockView.Vacate();
+			if (blockView.pending != nullptr) {
+				blockView.handle = blockView.pending->handle;
+				blockView.actionType = blockView.pending->actionType;
+			}
+			if (blockView.handle.IsValid() && blockView.handle.GetIndex() <= lastSlotIndex)
+				UE_LOG(LogTemp, Error, TEXT("Tick %d: dirty views should be walked once each, in index order"), i);
+			lastSlotIndex = FMath::Max(lastSlotIndex, blockView.handle.GetIndex());
+		});
+		if (blockViews.GetNumDirty() != 0)
+			UE_LOG(LogTemp, Error, TEXT("Tick %d: the walk should leave no dirty view"), i);
+
+		for (const auto& snapShot : blockPhysics.GetPublishedSnapShots()) {
+			const auto blockView = blockViews.Find(snapShot.handle);
+			if (blockView == nullptr || blockView->actionType != snapShot.actionType) {
+				UE_LOG(LogTemp, Error, TEXT("Tick %d: the view of block %d is out of date"), i, snapShot.handle.GetIndex());
+				return false;
+			}
+		}
+	}
+	if (removedHandles.Num() == 0)
+		UE_LOG(LogTemp, Error, TEXT("The swipe should have removed matched blocks"));
+	for (const auto blockHandle : removedHandles) {
+		if (blockViews.Find(blockHandle) != nullptr)
+			UE_LOG(LogTemp, Error, TEXT("A removed block's handle should not find a view"));
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(DestroySoundsShouldBeVoiceLimited, "Board.Getters.Destroy sounds of a tick should share a limited number of voices with specials first", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool DestroySoundsShouldBeVoiceLimited::RunTest(const FString& Parameters) {
+	auto blockPhysics = BlockPhysics(TestUtils::blockMatrix5x5);
+	blockPhysics.DisableTickDebugLog();
+	blockPhysics.ReceiveSwipeInput(FIntPoint{ 0, 3 }, FIntPoint{ 0, 2 });
+	auto aggregator = BlockDestroySoundAggregator();
+	auto voices = TArray<BlockDestroySoundAggregator::Voice>();
+	auto numDestroyStarted = 0;
+	auto numVoicedPops = 0;
+	for (int i = 0; i < 60; i++) {
+		blockPhysics.Tick(0.1f);
+		const auto& delta = blockPhysics.GetPublishedDelta();
+		numDestroyStarted += delta.destroyStarted.Num();
+		for (const auto& snapShot : delta.destroyStarted) {
+			if (snapShot.actionType != ActionType::GetsDestroyed)
+				UE_LOG(LogTemp, Error, TEXT("Tick %d: block %d should be getting destroyed"), i, snapShot.handle.GetIndex());
+		}
+		aggregator.Gather(delta);
+		aggregator.Flush(2, voices);
+		if (voices.Num() > 2)
+			UE_LOG(LogTemp, Error, TEXT("Tick %d: %d voices should be at most 2"), i, voices.Num());
+		for (const auto& voice : voices) {
+			numVoicedPops += voice.numPops;
+		}
+	}
+	if (numDestroyStarted == 0)
+		UE_LOG(LogTemp, Error, TEXT("The swipe should have started destroying matched blocks"));
+	if (numVoicedPops != numDestroyStarted)
+		UE_LOG(LogTemp, Error, TEXT("%d pops should be voiced but %d were"), numDestroyStarted, numVoicedPops);
+
+	// a line clear of a wide row along with a special
+	auto lineClear = PhysicalBlocksDelta();
+	for (int i = 0; i < 50; i++) {
+		lineClear.destroyStarted.Add(PhysicalBlockSnapShot(BlockHandle(i, 0), Block::ONE, ActionType::GetsDestroyed, FVector2D(0.f, i)));
+	}
+	lineClear.destroyStarted.Add(PhysicalBlockSnapShot(BlockHandle(50, 0), Block(BlockColor::ONE, BlockSpecialAttribute::HORIZONTAL_LINE_CLEAR), ActionType::GetsDestroyed, FVector2D(1.f, 0.f)));
+	aggregator.Gather(lineClear);
+	aggregator.Flush(3, voices);
+	if (voices.Num() != 3 || !voices[0].isSpecial || voices[0].numPops != 1) {
+		UE_LOG(LogTemp, Error, TEXT("The special pop should take the first of 3 voices"));
+		return false;
+	}
+	if (voices[1].numPops != 25 || voices[2].numPops != 25)
+		UE_LOG(LogTemp, Error, TEXT("The normal pops should be split evenly, not %d and %d"), voices[1].numPops, voices[2].numPops);
+	if (!(voices[1].volumeMultiplier > voices[0].volumeMultiplier) || voices[1].volumeMultiplier > BlockDestroySoundAggregator::MAX_VOLUME_MULTIPLIER)
+		UE_LOG(LogTemp, Error, TEXT("A voice of more pops should be louder, up to the limit"));
+	if (aggregator.GetNumGatheredPops() != 0)
+		UE_LOG(LogTemp, Error, TEXT("Flushing should start gathering anew"));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(LoadedStateShouldResumeMidCascade, "Board.Serialization.Loaded state should resume a cascade exactly where it was saved", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool LoadedStateShouldResumeMidCascade::RunTest(const FString& Parameters) {
+	auto original = BlockPhysics(TestUtils::blockMatrix5x5, 7);
+	original.DisableTickDebugLog();
+	original.ReceiveSwipeInput(FIntPoint{ 0, 3 }, FIntPoint{ 0, 2 });
+	for (int i = 0; i < 8; i++) {
+		original.Tick(0.1f);
+	}
+	auto bytes = TArray<uint8>();
+	original.SaveState(bytes);
+
+	auto restored = BlockPhysics(BlockMatrix());
+	restored.DisableTickDebugLog();
+	auto truncatedBytes = bytes;
+	truncatedBytes.SetNum(bytes.Num() - 1);
+	if (restored.LoadState(truncatedBytes) || restored.GetNumRows() != 0) {
+		UE_LOG(LogTemp, Error, TEXT("A truncated state should be rejected without touching the board"));
+		return false;
+	}
+	if (!restored.LoadState(bytes))
+		return false;
+
+	for (int i = 0; i < 40; i++) {
+		original.Tick(0.1f);
+		restored.Tick(0.1f);
+		const auto originalSnapShots = original.GetPublishedSnapShots();
+		const auto restoredSnapShots = restored.GetPublishedSnapShots();
+		if (originalSnapShots.Num() != restoredSnapShots.Num()) {
+			UE_LOG(LogTemp, Error, TEXT("Tick %d: %d blocks in the original but %d restored"), i, originalSnapShots.Num(), restoredSnapShots.Num());
+			return false;
+		}
+		for (int j = 0; j < originalSnapShots.Num(); j++) {
+			const auto& expected = originalSnapShots[j];
+			const auto& actual = restoredSnapShots[j];
+			if (expected.handle != actual.handle || expected.block != actual.block || expected.actionType != actual.actionType || expected.position != actual.position)
+				UE_LOG(LogTemp, Error, TEXT("Tick %d: restored block %d diverged from the original"), i, j);
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(ClonedBoardShouldBranchIndependently, "Board.Clone.Cloned board should follow the original without touching it", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool ClonedBoardShouldBranchIndependently::RunTest(const FString& Parameters) {
+	auto original = BlockPhysics(TestUtils::munchickenRollTest, 11);
+	original.DisableTickDebugLog();
+	original.ReceiveSwipeInput(FIntPoint{ 2, 2 }, FIntPoint{ 2, 3 });
+	original.Tick(0.1f);
+	auto clone = original.Clone();
+
+	const auto snapShotsBeforeBranching = original.GetPhysicalBlockSnapShots();
+	for (int i = 0; i < 30; i++) {
+		clone.Tick(0.1f);
+	}
+	const auto snapShotsAfterBranching = original.GetPhysicalBlockSnapShots();
+	if (snapShotsBeforeBranching.Num() != snapShotsAfterBranching.Num()) {
+		UE_LOG(LogTemp, Error, TEXT("Ticking the clone changed the original"));
+		return false;
+	}
+	for (int i = 0; i < snapShotsBeforeBranching.Num(); i++) {
+		if (snapShotsBeforeBranching[i].actionType != snapShotsAfterBranching[i].actionType || snapShotsBeforeBranching[i].position != snapShotsAfterBranching[i].position)
+			UE_LOG(LogTemp, Error, TEXT("Ticking the clone changed block %d of the original"), i);
+	}
+
+	for (int i = 0; i < 30; i++) {
+		original.Tick(0.1f);
+	}
+	const auto originalSnapShots = original.GetPhysicalBlockSnapShots();
+	const auto cloneSnapShots = clone.GetPhysicalBlockSnapShots();
+	if (originalSnapShots.Num() != cloneSnapShots.Num()) {
+		UE_LOG(LogTemp, Error, TEXT("The clone ended with %d blocks but the original with %d"), cloneSnapShots.Num(), originalSnapShots.Num());
+		return false;
+	}
+	for (int i = 0; i < originalSnapShots.Num(); i++) {
+		if (originalSnapShots[i].handle != cloneSnapShots[i].handle || originalSnapShots[i].block != cloneSnapShots[i].block || originalSnapShots[i].position != cloneSnapShots[i].position)
+			UE_LOG(LogTemp, Error, TEXT("Block %d of the clone diverged from the original"), i);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(BotShouldScoreOnlyMatchingSwipes, "Board.Bot.Bot should expect score only from swipes that match", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool BotShouldScoreOnlyMatchingSwipes::RunTest(const FString& Parameters) {
+	auto blockPhysics = BlockPhysics(TestUtils::blockMatrix5x5);
+	blockPhysics.DisableTickDebugLog();
+	const auto bot = BlockPhysicsBot(3);
+	const auto evaluations = bot.EvaluateSwipes(blockPhysics, 60.0, 1);
+	const auto* matchingSwipe = evaluations.FindByPredicate([](const SwipeEvaluation& evaluation) {
+		return evaluation.swipe == BlockSwipe(FIntPoint{ 0, 2 }, FIntPoint{ 0, 3 });
+	});
+	const auto* notMatchingSwipe = evaluations.FindByPredicate([](const SwipeEvaluation& evaluation) {
+		return evaluation.swipe == BlockSwipe(FIntPoint{ 4, 3 }, FIntPoint{ 4, 4 });
+	});
+	if (matchingSwipe == nullptr || notMatchingSwipe == nullptr) {
+		UE_LOG(LogTemp, Error, TEXT("Swipes between neighboring blocks should be available"));
+		return false;
+	}
+	if (matchingSwipe->numRollouts != BlockPhysicsBot::ROLLOUTS_PER_ROUND || matchingSwipe->GetExpectedScore() <= 0.f)
+		UE_LOG(LogTemp, Error, TEXT("A matching swipe should be expected to score"));
+	if (notMatchingSwipe->GetExpectedScore() != 0.f)
+		UE_LOG(LogTemp, Error, TEXT("A swipe that returns should be expected to score nothing"));
+
+	const auto reevaluations = bot.EvaluateSwipes(blockPhysics, 60.0, 1);
+	for (int i = 0; i < evaluations.Num(); i++) {
+		if (evaluations[i].totalScore != reevaluations[i].totalScore)
+			UE_LOG(LogTemp, Error, TEXT("Evaluations with the same seed should be deterministic"));
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(BotShouldKeepItsTimeBudgetOnALargeBoard, "Board.Bot.Bot should keep its time budget on the largest board", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool BotShouldKeepItsTimeBudgetOnALargeBoard::RunTest(const FString& Parameters) {
+	const auto size = BlockPhysics::MAX_ROW_COL_SIZE;
+	auto blockMatrix = BlockMatrix(size, size);
+	// no three in a row anywhere, so that the board starts settled
+	for (int row = 0; row < size; row++) {
+		for (int col = 0; col < size; col++) {
+			blockMatrix.SetAt(row, col, Block(validColors[(row % 2) * 2 + (col / 2) % 2], BlockSpecialAttribute::NONE));
+		}
+	}
+	auto blockPhysics = BlockPhysics(blockMatrix);
+	blockPhysics.DisableTickDebugLog();
+	const auto bot = BlockPhysicsBot(3);
+	const auto timeBudgetSeconds = 0.05;
+	const auto startTime = FPlatformTime::Seconds();
+	const auto evaluations = bot.EvaluateSwipes(blockPhysics, timeBudgetSeconds);
+	const auto elapsedSeconds = FPlatformTime::Seconds() - startTime;
+	if (evaluations.Num() == 0)
+		UE_LOG(LogTemp, Error, TEXT("The board should have swipes to evaluate"));
+	// slack for the rollouts already running at the deadline, and for building the swipe list
+	if (elapsedSeconds > timeBudgetSeconds + 0.5)
+		UE_LOG(LogTemp, Error, TEXT("Evaluation took %f seconds on a budget of %f"), elapsedSeconds, timeBudgetSeconds);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(BoardHashShouldFollowBoardContents, "Board.Hash.Board hash should depend only on the blocks on the board", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool BoardHashShouldFollowBoardContents::RunTest(const FString& Parameters) {
+	auto blockMatrix = BlockMatrix(TestUtils::blockMatrix5x5.GetBlock2DArray());
+	const auto initialHash = blockMatrix.GetHash();
+	if (initialHash != TestUtils::blockMatrix5x5.GetHash())
+		UE_LOG(LogTemp, Error, TEXT("Equal boards should hash equally"));
+	blockMatrix.SetAt(0, 2, Block::ONE);
+	blockMatrix.SetAt(0, 3, Block::TWO);
+	if (blockMatrix.GetHash() == initialHash)
+		UE_LOG(LogTemp, Error, TEXT("Swapping two different blocks should change the hash"));
+	blockMatrix.SetAt(0, 2, Block::TWO);
+	blockMatrix.SetAt(0, 3, Block::ONE);
+	if (blockMatrix.GetHash() != initialHash)
+		UE_LOG(LogTemp, Error, TEXT("Swapping back should restore the hash"));
+
+	auto blockPhysics = BlockPhysics(TestUtils::blockMatrix5x5);
+	blockPhysics.DisableTickDebugLog();
+	blockPhysics.ReceiveSwipeInput(FIntPoint{ 4, 3 }, FIntPoint{ 4, 4 });
+	if (blockPhysics.GetBoardHash() == initialHash)
+		UE_LOG(LogTemp, Error, TEXT("Blocks leaving the grid should change the hash"));
+	for (int i = 0; i < 20; i++) {
+		blockPhysics.Tick(0.1f);
+	}
+	if (blockPhysics.IsInAction() || blockPhysics.GetBoardHash() != initialHash)
+		UE_LOG(LogTemp, Error, TEXT("A swipe that returned should leave the hash as it was"));
+
+	auto cache = BoardHashCache<int32>(2, 1);
+	cache.Add(1, 10);
+	cache.Add(2, 20);
+	cache.Find(1);
+	cache.Add(3, 30);
+	const auto value = cache.Find(1);
+	if (!value || *value != 10 || cache.Find(2) || cache.Num() != 2)
+		UE_LOG(LogTemp, Error, TEXT("The cache should evict the entry that wasn't hit since the clock hand passed"));
+	// shards evict on their own, but together hold the whole capacity
+	auto shardedCache = BoardHashCache<int32>(64, 4);
+	for (uint64 hash = 0; hash < 64; hash++) {
+		shardedCache.Add(hash << 48, static_cast<int32>(hash));
+	}
+	const auto shardedValue = shardedCache.Find(uint64(5) << 48);
+	if (shardedCache.Num() != 64 || !shardedValue || *shardedValue != 5)
+		UE_LOG(LogTemp, Error, TEXT("A sharded cache should hold its whole capacity"));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(ParallelMatchScanShouldEqualSerialScan, "Board.Match.Parallel match scan of a giant board should equal the serial scan", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool ParallelMatchScanShouldEqualSerialScan::RunTest(const FString& Parameters) {
+	// Three colors on a board over the size limit, so that formations of every kind cross the band boundaries.
+	const auto size = 64;
+	auto blockMatrix = BlockMatrix(size, size);
+	auto randomGenerator = BlockRandomGenerator();
+	for (int row = 0; row < size; row++) {
+		for (int col = 0; col < size; col++) {
+			blockMatrix.SetAt(row, col, Block(validColors[randomGenerator.NextInRange(3)], BlockSpecialAttribute::NONE));
+		}
+	}
+	const auto serialMatches = blockMatrix.GetMatches(false);
+	const auto parallelMatches = blockMatrix.GetMatches();
+	if (serialMatches.Num() == 0)
+		UE_LOG(LogTemp, Error, TEXT("The board should have matches"));
+	if (serialMatches.Num() != parallelMatches.Num())
+		UE_LOG(LogTemp, Error, TEXT("Parallel scan found %d matches, serial scan found %d"), parallelMatches.Num(), serialMatches.Num());
+	for (const auto& match : serialMatches) {
+		const auto* parallelMatch = parallelMatches.Find(match);
+		if (parallelMatch == nullptr || parallelMatch->GetMatchedColor() != match.GetMatchedColor())
+			UE_LOG(LogTemp, Error, TEXT("Parallel scan missed the match at (%d, %d)"), match.GetLocation().X, match.GetLocation().Y);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(ExplosionMaskShouldCoverItsRowsColumnsAndCells, "Board.Explosion.Explosion mask should cover its rows, columns and cells", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool ExplosionMaskShouldCoverItsRowsColumnsAndCells::RunTest(const FString& Parameters) {
+	auto explosionMask = ExplosionMask(5, 5);
+	if (!explosionMask.IsEmpty() || explosionMask.Contains(FIntPoint{ 2, 2 }))
+		UE_LOG(LogTemp, Error, TEXT("A new mask should be empty"));
+	explosionMask.AddRow(1);
+	explosionMask.AddColumn(3);
+	explosionMask.AddCell(FIntPoint{ 4, 0 });
+	explosionMask.AddCell(FIntPoint{ 5, 0 });
+	const auto coveredCells = TArray<FIntPoint>{ { 1, 0 }, { 1, 4 }, { 1, 5 }, { 0, 3 }, { 4, 3 }, { -1, 3 }, { 4, 0 } };
+	for (const auto& cell : coveredCells) {
+		if (!explosionMask.Contains(cell))
+			UE_LOG(LogTemp, Error, TEXT("Cell (%d, %d) should be covered"), cell.X, cell.Y);
+	}
+	const auto uncoveredCells = TArray<FIntPoint>{ { 0, 0 }, { 2, 2 }, { 5, 0 }, { -1, 0 } };
+	for (const auto& cell : uncoveredCells) {
+		if (explosionMask.Contains(cell))
+			UE_LOG(LogTemp, Error, TEXT("Cell (%d, %d) should not be covered"), cell.X, cell.Y);
+	}
+	explosionMask.Reset(5, 5);
+	if (!explosionMask.IsEmpty() || explosionMask.Contains(FIntPoint{ 1, 0 }))
+		UE_LOG(LogTemp, Error, TEXT("A reset mask should be empty"));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(SegmentQueriesShouldFindBlocksBetweenLatticePoints, "Board.Getters.Segment queries should find blocks between lattice points", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool SegmentQueriesShouldFindBlocksBetweenLatticePoints::RunTest(const FString& Parameters) {
+	auto blockPhysics = BlockPhysics(TestUtils::munchickenRollTest);
+	blockPhysics.DisableTickDebugLog();
+	blockPhysics.ReceiveSwipeInput(FIntPoint{ 1, 1 }, FIntPoint{ 1, 2 });
+	// both swiped blocks halfway, at (1, 1.5)
+	blockPhysics.Tick(0.5f * BlockPhysics::GRID_SIZE / BlockPhysics::SWIPE_MOVE_SPEED);
+
+	// (1, 0)'s body ends just short of y = 0.5, and the swiped blocks' bodies start just past y = 1
+	if (!blockPhysics.FindFirstBlockOnRay(FVector2D(1.f, 0.7f), FVector2D(0.f, 1.f), 0.5f).position.Equals(FVector2D(1.f, 1.5f)))
+		UE_LOG(LogTemp, Error, TEXT("The ray should hit the swiped blocks"));
+	if (blockPhysics.FindFirstBlockOnRay(FVector2D(1.f, 0.7f), FVector2D(0.f, 1.f), 0.2f).handle.IsValid())
+		UE_LOG(LogTemp, Error, TEXT("The ray should end before the swiped blocks"));
+	// between rows 0 and 1, where no block is
+	if (blockPhysics.FindFirstBlockOnSegment(FVector2D(0.5f, -1.f), FVector2D(0.5f, 4.f)).handle.IsValid())
+		UE_LOG(LogTemp, Error, TEXT("The segment between the rows should hit nothing"));
+	const auto firstBlock = blockPhysics.FindFirstBlockOnSegment(FVector2D(3.f, 3.f), FVector2D(0.f, 0.f));
+	if (!firstBlock.position.Equals(FVector2D(3.f, 3.f)))
+		UE_LOG(LogTemp, Error, TEXT("The diagonal should hit (3, 3) first but hit (%f, %f)"), firstBlock.position.X, firstBlock.position.Y);
+	if (!blockPhysics.ExistsBlockBetween(FIntPoint{ 1, 1 }, FIntPoint{ 1, 2 }))
+		UE_LOG(LogTemp, Error, TEXT("The swiped blocks should be between their cells"));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(SegmentQueriesShouldHitBlockBodiesOffTheLattice, "Board.Getters.Segment queries should hit block bodies off the lattice", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool SegmentQueriesShouldHitBlockBodiesOffTheLattice::RunTest(const FString& Parameters) {
+	auto blockPhysics = BlockPhysics(TestUtils::munchickenRollTest);
+	blockPhysics.DisableTickDebugLog();
+	blockPhysics.ReceiveSwipeInput(FIntPoint{ 1, 1 }, FIntPoint{ 1, 2 });
+	// both swiped blocks halfway, at (1, 1.5)
+	blockPhysics.Tick(0.5f * BlockPhysics::GRID_SIZE / BlockPhysics::SWIPE_MOVE_SPEED);
+
+	// starts inside the swiped blocks' bodies, 0.3 off their column
+	if (!blockPhysics.FindFirstBlockOnRay(FVector2D(1.3f, 1.2f), FVector2D(0.f, 1.f), 0.5f).position.Equals(FVector2D(1.f, 1.5f)))
+		UE_LOG(LogTemp, Error, TEXT("The ray off the column should hit the swiped blocks"));
+	// crosses row 1 at y = 1.3 on its way from between rows 0 and 1 to between rows 1 and 2
+	const auto hit = blockPhysics.FindFirstBlockOnSegment(FVector2D(0.5f, 1.1f), FVector2D(1.5f, 1.5f));
+	if (!hit.position.Equals(FVector2D(1.f, 1.5f)))
+		UE_LOG(LogTemp, Error, TEXT("The slanted segment should hit the swiped blocks but hit (%f, %f)"), hit.position.X, hit.position.Y);
+	// from between (1, 0) and the swiped blocks, stopping short of the latter
+	if (blockPhysics.FindFirstBlockOnRay(FVector2D(1.3f, 0.6f), FVector2D(0.f, 1.f), 0.3f).handle.IsValid())
+		UE_LOG(LogTemp, Error, TEXT("The ray off the column should stop short of the swiped blocks"));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(LogicalGridShouldHoldIdleBlocks, "Board.Getters.Logical grid should hold exactly the idle blocks after every tick", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool LogicalGridShouldHoldIdleBlocks::RunTest(const FString& Parameters) {
+	auto blockPhysics = BlockPhysics(TestUtils::blockMatrix5x5);
+	blockPhysics.DisableTickDebugLog();
+	blockPhysics.ReceiveSwipeInput(FIntPoint{ 0, 3 }, FIntPoint{ 0, 2 });
+	for (int i = 0; i < 60; i++) {
+		blockPhysics.Tick(0.1f);
+		auto expectedGrid = BlockMatrix(blockPhysics.GetNumRows(), blockPhysics.GetNumCols());
+		for (const auto& snapShot : blockPhysics.GetPublishedSnapShots()) {
+			const auto cell = BlockPhysics::ToFIntPoint(snapShot.position);
+			if (snapShot.actionType == ActionType::Idle)
+				expectedGrid.SetAt(cell.X, cell.Y, snapShot.block);
+		}
+		if (expectedGrid.GetBlock2DArray() != blockPhysics.GetBlockMatrix().GetBlock2DArray()) {
+			UE_LOG(LogTemp, Error, TEXT("Tick %d: the logical grid differs from the idle blocks"), i);
+			return false;
+		}
+	}
+	return true;
+}
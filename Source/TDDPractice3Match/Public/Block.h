@@ -1,9 +1,10 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "ExplosionArea.h"
 
 // When this enum gets updated, below arrays should be too.
+class ExplosionMask;
+
 enum class TDDPRACTICE3MATCH_API BlockColor {
     ZERO,
     ONE,
@@ -50,14 +51,11 @@ public:
     BlockSpecialAttribute GetSpecialAttribute() const { return specialAttribute; }
 	bool IsSpecial() const { return specialAttribute != BlockSpecialAttribute::NONE; }
 	bool HasDecoratorAttribute() const { return decoratorAttributes.Contains(specialAttribute);	}
-    TUniquePtr<ExplosionArea> GetExplosionArea(const FVector2D& blockPosition, float gridSize) const {
-        if (specialAttribute == BlockSpecialAttribute::VERTICAL_LINE_CLEAR)
-            return MakeUnique<VerticalLineExplosionArea>(blockPosition, gridSize);
-        else if (specialAttribute == BlockSpecialAttribute::HORIZONTAL_LINE_CLEAR)
-            return MakeUnique<HorizontalLineExplosionArea>(blockPosition, gridSize);
-        else
-            return MakeUnique<EmptyExplosionArea>();
-    }
+	// 3 bits of color, then 3 bits of special attribute; distinct for every block
+	uint8 Pack() const { return static_cast<uint8>(static_cast<uint8>(color) | (static_cast<uint8>(specialAttribute) << 3)); }
+    // Rasterizes the explosion of this block, destroyed at the given cell, into the mask.
+    // A one color clear clears its own color, so a colorless one adds nothing.
+    void AddExplosionTo(ExplosionMask& explosionMask, FIntPoint cell) const;
 
     bool operator==(const Block& otherBlock) const;
     bool operator!=(const Block& otherBlock) const { return !(*this == otherBlock); }
@@ -69,12 +67,16 @@ public:
     const static Block THREE;
     const static Block FOUR;
     const static Block MUNCHICKEN;
+    // Manhattan radius of the cells a DIAMOND_NEIGHBORHOOD_CLEAR clears
+    constexpr static int DIAMOND_CLEAR_RADIUS = 2;
 
 private:
     BlockColor color;
     BlockSpecialAttribute specialAttribute;
 };
 uint32 GetTypeHash(const Block& block);
+// Stored as Pack()
+FArchive& operator<<(FArchive& archive, Block& block);
 
 FString PrettyPrint(BlockColor color);
 FString PrettyPrint(BlockSpecialAttribute specialAttribute);
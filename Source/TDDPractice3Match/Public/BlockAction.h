@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Block.h"
+#include "BlockHandle.h"
 
 enum class ActionType {
 	Idle,
@@ -17,9 +18,33 @@ enum class ActionType {
 
 FString PrettyPrint(ActionType actionType);
 
+// Tags the concrete action class in saved board states. Values are persisted, so only append.
+enum class BlockActionClass : uint8 {
+	Idle,
+	SwipeMove,
+	SwipeReturn,
+	Fall,
+	GetsDestroyed,
+	GetsDestroyedAndSpawnBlockAfter,
+	Roll,
+	GetsDestroyedInBackground
+};
+
+class BlockPhysics;
+
+// Lattice cells an action passed over in its last tick: numCells cells from firstCell on, one step apart, in the order they were passed
+class SweptSegment {
+public:
+	// The part of the segment within a board of the given size
+	SweptSegment ClipTo(int numRows, int numCols) const;
+	FIntPoint firstCell = FIntPoint::ZeroValue;
+	FIntPoint step = FIntPoint::ZeroValue;
+	int numCells = 0;
+};
+
 class BlockAction {
 public:
-	BlockAction(FVector2D initialPos) :position(initialPos) {}
+	BlockAction(FVector2D initialPos);
 	virtual ~BlockAction() {}
 	virtual void Tick(float deltaSeconds) = 0;
 	virtual bool IsJustCompleted() const = 0;
@@ -33,8 +58,16 @@ public:
 	virtual FVector2D GetOccupiedPosition() const { return GetPosition(); }
 	// lower int means lower layer
 	virtual int GetLayer() const { return 0; }
+	virtual SweptSegment GetSweptSegment() const { return SweptSegment(); }
 
 	virtual ActionType GetType() const = 0;
+	virtual BlockActionClass GetActionClass() const = 0;
+	// Deep copy, progress included, for the board that will own it
+	virtual TUniquePtr<BlockAction> Clone(BlockPhysics& owner) const = 0;
+	// Reads or writes everything needed to resume the action where it was
+	virtual void Serialize(FArchive& archive) { archive << position; }
+	// returns a placeholder of the class for Serialize to fill in, or nullptr for an unknown class
+	static TUniquePtr<BlockAction> CreateForLoading(BlockActionClass actionClass, BlockPhysics& blockPhysics, BlockHandle handle);
 protected:
 	FVector2D position;
 };
@@ -49,6 +82,8 @@ public:
 	virtual TUniquePtr<BlockAction> GetNextAction(bool thereIsAMatch) const { return nullptr; }
 
 	virtual ActionType GetType() const { return ActionType::Idle; }
+	virtual BlockActionClass GetActionClass() const override { return BlockActionClass::Idle; }
+	virtual TUniquePtr<BlockAction> Clone(BlockPhysics& owner) const override { return MakeUnique<IdleBlockAction>(*this); }
 };
 
 class SwipeMoveBlockAction : public BlockAction {
@@ -62,6 +97,9 @@ public:
 	virtual FVector2D GetOccupiedPosition() const override { return initialPos; }
 
 	virtual ActionType GetType() const { return ActionType::SwipeMove; }
+	virtual BlockActionClass GetActionClass() const override { return BlockActionClass::SwipeMove; }
+	virtual TUniquePtr<BlockAction> Clone(BlockPhysics& owner) const override { return MakeUnique<SwipeMoveBlockAction>(*this); }
+	virtual void Serialize(FArchive& archive) override;
 private:
 	FIntPoint initialPos, destPos;
 	bool isJustCompleted = false;
@@ -78,6 +116,9 @@ public:
 	virtual FVector2D GetOccupiedPosition() const override { return initialPos; }
 
 	virtual ActionType GetType() const { return ActionType::SwipeReturn; }
+	virtual BlockActionClass GetActionClass() const override { return BlockActionClass::SwipeReturn; }
+	virtual TUniquePtr<BlockAction> Clone(BlockPhysics& owner) const override { return MakeUnique<SwipeReturnBlockAction>(*this); }
+	virtual void Serialize(FArchive& archive) override;
 private:
 	FIntPoint initialPos, destPos;
 	bool isJustCompleted = false;
@@ -93,6 +134,9 @@ public:
 	virtual TUniquePtr<BlockAction> GetNextAction(bool thereIsAMatch) const { return MakeUnique<IdleBlockAction>(position); }
 
 	virtual ActionType GetType() const { return ActionType::Fall; }
+	virtual BlockActionClass GetActionClass() const override { return BlockActionClass::Fall; }
+	virtual TUniquePtr<BlockAction> Clone(BlockPhysics& owner) const override { return MakeUnique<FallingBlockAction>(*this); }
+	virtual void Serialize(FArchive& archive) override;
 private:
 	FIntPoint initialPos, destPos;
 	float currentSpeed = 0.f;
@@ -110,6 +154,9 @@ public:
 	virtual TUniquePtr<BlockAction> GetNextAction(bool thereIsAMatch) const { return nullptr; }
 
 	virtual ActionType GetType() const { return ActionType::GetsDestroyed; }
+	virtual BlockActionClass GetActionClass() const override { return BlockActionClass::GetsDestroyed; }
+	virtual TUniquePtr<BlockAction> Clone(BlockPhysics& owner) const override { return MakeUnique<GetsDestroyedBlockAction>(*this); }
+	virtual void Serialize(FArchive& archive) override;
 private:
 	float elapsedTime = 0.0f;
 	bool completed = false;
@@ -121,14 +168,16 @@ public:
 	virtual TUniquePtr<BlockAction> GetNextAction(bool thereIsAMatch) const override;
 	virtual bool ShouldBeRemoved() const override { return false; }
 	virtual Block GetNextBlock(Block originalBlock) const override { return blockToSpawnAfterDestroy; }
+	virtual BlockActionClass GetActionClass() const override { return BlockActionClass::GetsDestroyedAndSpawnBlockAfter; }
+	virtual TUniquePtr<BlockAction> Clone(BlockPhysics& owner) const override { return MakeUnique<GetsDestroyedAndSpawnBlockAfterAction>(*this); }
+	virtual void Serialize(FArchive& archive) override;
 private:
 	Block blockToSpawnAfterDestroy;
 };
 
-class BlockPhysics;
 class MunchickenRollAction : public BlockAction {
 public:
-	MunchickenRollAction(FVector2D initialPos, FIntPoint rollDirection, BlockPhysics& blockPhysics, int rollableId);
+	MunchickenRollAction(FVector2D initialPos, FIntPoint rollDirection, BlockPhysics& blockPhysics, BlockHandle rollableHandle);
 
 	void Tick(float deltaSeconds) override;
 	bool IsJustCompleted() const override;
@@ -136,19 +185,22 @@ public:
 	bool IsEligibleForMatching() const override;
 	TUniquePtr<BlockAction> GetNextAction(bool thereIsAMatch) const override;
 	virtual FVector2D GetOccupiedPosition() const { return lastRolledOverPosition; }
+	// Unclipped, so that a long tick doesn't tunnel past cells
+	SweptSegment GetSweptSegment() const override;
 	ActionType GetType() const override;
+	BlockActionClass GetActionClass() const override { return BlockActionClass::Roll; }
+	// rebinds to the owner so that the clone rolls over the owner's blocks
+	TUniquePtr<BlockAction> Clone(BlockPhysics& owner) const override;
+	void Serialize(FArchive& archive) override;
 
 private:
 	void UpdatePosition(float deltaSeconds);
-	TSet<FIntPoint> GetCellPositionsRolledOver() const;
-	static TSet<int> GetIntegersBetween(float bound1, float bound2);
-	void ApplyRollOverEffectAt(const TSet<FIntPoint>& destroyPositions);
 	bool IsOutOfTheMap() const;
 	FVector2D previousPosition;
 	FIntPoint lastRolledOverPosition;
 	FIntPoint rollDirection;
 	BlockPhysics& blockPhysics;
-	int rollableId;
+	BlockHandle rollableHandle;
 	enum RollType {
 		Invalid,
 		Vertical,
@@ -163,6 +215,8 @@ public:
 	GetsDestroyedInBackgroundBlockAction(FVector2D initialPos) : GetsDestroyedBlockAction(initialPos) {}
 	int GetLayer() const override { return -1; }
 	FVector2D GetOccupiedPosition() const override { return INVALID_POSITION; }
+	BlockActionClass GetActionClass() const override { return BlockActionClass::GetsDestroyedInBackground; }
+	TUniquePtr<BlockAction> Clone(BlockPhysics& owner) const override { return MakeUnique<GetsDestroyedInBackgroundBlockAction>(*this); }
 private:
 	const static FIntPoint INVALID_POSITION;
 };
\ No newline at end of file
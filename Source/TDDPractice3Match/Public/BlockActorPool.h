@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+
+// Deactivated block actors kept for reuse, one free list per kind, so that blocks appearing and disappearing
+// hide and move actors instead of spawning and destroying them.
+// Kinds are plain indices; the owner decides what they stand for and spawns the actors on a miss.
+class TDDPRACTICE3MATCH_API BlockActorPool {
+public:
+	void Reset(int numKinds);
+	// Returns nullptr on a miss, when the kind has no free actor left
+	AActor* Acquire(int kind, const FVector& location, const FRotator& rotation);
+	// Hides the actor until it gets acquired again
+	void Release(int kind, AActor* actor);
+	int GetNumFree(int kind) const { return freeActorsPerKind[kind].Num(); }
+	// Destroys the free actors; actors in use stay with whoever acquired them
+	void DestroyFreeActors();
+
+	int64 GetNumHits() const { return numHits; }
+	int64 GetNumMisses() const { return numMisses; }
+	// 1 when nothing has been acquired yet
+	float GetHitRate() const;
+
+	static void Activate(AActor* actor, const FVector& location, const FRotator& rotation);
+	static void Deactivate(AActor* actor);
+private:
+	TArray<TArray<AActor*>> freeActorsPerKind;
+	int64 numHits = 0;
+	int64 numMisses = 0;
+};
@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class PhysicalBlocksDelta;
+
+// Gathers the pops of the blocks that started getting destroyed, and plays them as a few voices instead of one sound
+// per block. A voice standing for several pops gets louder and higher the more pops it stands for.
+class TDDPRACTICE3MATCH_API BlockDestroySoundAggregator {
+public:
+	class Voice {
+	public:
+		bool isSpecial = false;
+		int numPops = 0;
+		float volumeMultiplier = 1.f;
+		float pitchMultiplier = 1.f;
+	};
+
+	void Gather(const PhysicalBlocksDelta& delta);
+	// Splits what was gathered into at most maxVoices voices, specials first, and starts gathering anew.
+	// Special pops share a voice; normal pops are spread evenly over the voices left.
+	void Flush(int maxVoices, TArray<Voice>& outVoices);
+	int GetNumGatheredPops() const { return numNormalPops + numSpecialPops; }
+
+	constexpr static float VOLUME_STEP_PER_DOUBLING = 0.15f;
+	constexpr static float MAX_VOLUME_MULTIPLIER = 1.6f;
+	constexpr static float PITCH_STEP_PER_DOUBLING = 0.04f;
+	constexpr static float MAX_PITCH_MULTIPLIER = 1.25f;
+private:
+	static Voice MakeVoice(bool isSpecial, int numPops);
+
+	int numNormalPops = 0;
+	int numSpecialPops = 0;
+};
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Identifies a block for its whole lifetime on one board. The generation makes handles of removed blocks stale
+// instead of letting them alias a block that later reuses the same slot.
+class TDDPRACTICE3MATCH_API BlockHandle {
+public:
+	BlockHandle() {}
+	BlockHandle(int32 index, int32 generation) : index(index), generation(generation) {}
+	bool IsValid() const { return index != INDEX_NONE; }
+	int32 GetIndex() const { return index; }
+	int32 GetGeneration() const { return generation; }
+	bool operator==(const BlockHandle& other) const { return (index == other.index) && (generation == other.generation); }
+	bool operator!=(const BlockHandle& other) const { return !(*this == other); }
+
+	const static BlockHandle INVALID;
+private:
+	int32 index = INDEX_NONE;
+	int32 generation = 0;
+};
+uint32 GetTypeHash(const BlockHandle& handle);
+
+// Maps handles to the current index of their block in a dense array that gets compacted.
+class TDDPRACTICE3MATCH_API BlockHandleTable {
+public:
+	BlockHandle Allocate(int32 denseIndex);
+	void Release(BlockHandle handle);
+	void SetDenseIndex(BlockHandle handle, int32 denseIndex);
+	// returns INDEX_NONE if the handle is stale
+	int32 FindDenseIndex(BlockHandle handle) const;
+	bool IsAlive(BlockHandle handle) const { return FindDenseIndex(handle) != INDEX_NONE; }
+	int32 GetNumSlots() const { return slots.Num(); }
+	void Save(FArchive& archive) const;
+	// sets an error on the archive if the table doesn't fit in what's left of it
+	void Load(FArchive& archive);
+private:
+	class Slot {
+	public:
+		int32 generation = 0;
+		int32 denseIndex = INDEX_NONE;
+	};
+	TArray<Slot> slots;
+	TArray<int32> freeSlotIndices;
+};
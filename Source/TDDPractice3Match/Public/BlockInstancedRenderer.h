@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BlockHandle.h"
+
+class AActor;
+class UWorld;
+class UPaperSprite;
+class UPaperGroupedSpriteComponent;
+
+// Draws blocks as instances of one grouped sprite component per layer, all on a single host actor, so that the number of
+// actors and components doesn't grow with the board. Each block has a body and optionally a decorator, in any layers.
+// Transforms are gathered per layer and handed to the components in one batch on Flush.
+// Block actors use it for their decorators alone, so that decorating a block doesn't register a component.
+class TDDPRACTICE3MATCH_API BlockInstancedRenderer {
+public:
+	enum Part {
+		Body,
+		Decorator,
+		NUM_PARTS
+	};
+
+	// Spawns the host actor with a component for each sprite; blocks shown in a layer without a sprite aren't drawn
+	bool Initialize(UWorld* world, const TArray<UPaperSprite*>& layerSprites);
+	bool IsInitialized() const { return hostActor != nullptr; }
+	// Moves the part's instance, taking one from the layer if the part isn't there yet
+	void Show(BlockHandle handle, Part part, int layer, const FTransform& transform);
+	// The instance stays allocated, shrunk to nothing, for the next block shown in the layer
+	void Hide(BlockHandle handle, Part part);
+	void HideAll(BlockHandle handle);
+	// Hands the transforms gathered since the last flush to the components, marking each changed component dirty once
+	void Flush();
+	int GetNumInstances(int layer) const;
+
+private:
+	class Layer {
+	public:
+		UPaperGroupedSpriteComponent* component = nullptr;
+		UPaperSprite* sprite = nullptr;
+		TArray<int32> freeInstanceIndices;
+		TArray<int32> pendingInstanceIndices;
+		TArray<FTransform> pendingTransforms;
+	};
+	class PartInstance {
+	public:
+		int32 layer = INDEX_NONE;
+		int32 instanceIndex = INDEX_NONE;
+	};
+	PartInstance& GetPartInstance(BlockHandle handle, Part part);
+	void SetPendingTransform(Layer& layer, int32 instanceIndex, const FTransform& transform);
+
+	AActor* hostActor = nullptr;
+	TArray<Layer> layers;
+	// NUM_PARTS per handle index
+	TArray<PartInstance> partInstances;
+};
@@ -29,6 +29,7 @@ uint32 GetTypeHash(const Match& match);
 class TDDPRACTICE3MATCH_API MatchResult {
 public:
 	TSet<FIntPoint> GetMatchedPositions() const { return allMatchedPositions; }
+	bool HasMatchedPosition(FIntPoint position) const { return allMatchedPositions.Contains(position); }
 	TSet<TPair<Block, FIntPoint>> GetSpecialBlockAndItsSpawnPositions() const { return specialBlockSpawnPositions; }
 	void AddMatchedPositions(const TSet<FIntPoint>& matchedPositions);
 	void AddSpecialBlockWith(Block specialBlock, FIntPoint defaultSpawnPosition, const TSet<FIntPoint>& matchedPositions, const TSet<FIntPoint>& specialBlockSpawnCandidatePositions);
@@ -43,25 +44,40 @@ private:
 class TDDPRACTICE3MATCH_API BlockMatrix {
 public:
 	BlockMatrix() {}
-	BlockMatrix(int numRows, int numCols, const TMap<FIntPoint, Block> blockMatrix);
+	// every cell starts as Block::INVALID
+	BlockMatrix(int numRows, int numCols);
 	BlockMatrix(const TArray<TArray<Block>>& block2DArray);
-	TArray<TArray<Block>> GetBlock2DArray() const { return block2DArray; }
+	TArray<TArray<Block>> GetBlock2DArray() const;
 	bool HasNoMatch() const;
 	Block At(int row, int col) const;
+	void SetAt(int row, int col, Block block);
 	MatchResult ProcessMatch(const TSet<FIntPoint>& specialBlockSpawnCandidatePositions);
-	TSet<Match> GetMatches() const;
+	// For callers that already have GetMatches() of this matrix, so the board isn't scanned twice
+	MatchResult ProcessMatch(const TSet<Match>& matches, const TSet<FIntPoint>& specialBlockSpawnCandidatePositions);
+	// Boards with at least PARALLEL_SCAN_MIN_CELLS cells are scanned in row bands on worker threads.
+	// The result is the same as the serial scan's either way; only the serial scan is allocation free.
+	TSet<Match> GetMatches(bool allowParallelScan = true) const;
 	int GetNumRows() const { return numRows; }
 	int GetNumCols() const { return numCols; }
+	// Zobrist hash of the (cell, block) pairs, kept up to date by every change to the matrix
+	uint64 GetHash() const { return hash; }
+
+	constexpr static int PARALLEL_SCAN_MIN_CELLS = 48 * 48;
+	constexpr static int ROWS_PER_SCAN_BAND = 8;
 private:
-	void RemoveBlocksAt(const TSet<FIntPoint>& positions);
+	static uint64 GetZobristKey(int row, int col, Block block);
+	void RemoveBlockAt(FIntPoint position);
 	static int GetRow(FIntPoint point) { return point.X; }
 	static int GetCol(FIntPoint point) { return point.Y; }
+	int ToIndex(int row, int col) const { return row * numCols + col; }
 	bool IsOutOfMatrix(FIntPoint point) const;
 	TArray<Match> FindAMatchAt(FIntPoint point) const;
+	void FindMatchesAnchoredInRows(int beginRow, int endRow, TArray<Match>& outMatches) const;
 	bool IsFormationOutOfMatrix(const Formation& formation, FIntPoint point) const;
 	bool ColorOfBlocksConsistentIn(const Formation& formation, FIntPoint point) const;
 	int numRows = 0;
 	int numCols = 0;
-	TMap<FIntPoint, Block> blockMatrix;
-	TArray<TArray<Block>> block2DArray;
+	// row-major; removed or empty cells hold Block::INVALID
+	TArray<Block> blocks;
+	uint64 hash = 0;
 };
\ No newline at end of file
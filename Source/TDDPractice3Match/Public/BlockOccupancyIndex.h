@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Blocks bucketed by the cells their bodies overlap, so that a query visits only the cells it covers.
+// Cells are unit squares centered on lattice points, and so are block bodies, centered on the blocks' continuous positions.
+// A block resting on a lattice point is bucketed in its cell only; one between lattice points, in every cell its body overlaps.
+// The rows above the board are indexed too, for the blocks falling in.
+class TDDPRACTICE3MATCH_API BlockOccupancyIndex {
+public:
+	// Empties the index, keeping its memory when the size doesn't change
+	void Reset(int newNumRows, int newNumCols);
+	// Cells of the body off the indexed ones are dropped
+	void Add(int32 blockIndex, FVector2D position);
+
+	// Calls visit(blockIndex) for every block bucketed in the cell, in the reverse order they were added
+	template<typename VisitorType>
+	void ForEachBlockIn(FIntPoint cell, VisitorType visit) const
+	{
+		if (!IsIndexed(cell))
+			return;
+		for (auto entryIndex = cellHeads[ToCellIndex(cell)]; entryIndex != INDEX_NONE; entryIndex = entries[entryIndex].next) {
+			visit(entries[entryIndex].blockIndex);
+		}
+	}
+
+	// Calls visit(cell) for the cells the segment crosses, from start to end, until visit returns false.
+	// Cells off the indexed ones are visited as well; they hold no blocks.
+	template<typename VisitorType>
+	static void ForEachCellOnSegment(FVector2D start, FVector2D end, VisitorType visit)
+	{
+		// Grid DDA: step into whichever neighboring cell the segment enters first, with t running from 0 at start to 1 at end.
+		const auto delta = end - start;
+		auto cell = ToCell(start);
+		const auto endCell = ToCell(end);
+		const auto step = FIntPoint{ FMath::Sign(endCell.X - cell.X), FMath::Sign(endCell.Y - cell.Y) };
+		auto nextRowCrossing = GetFirstCrossing(start.X, delta.X, cell.X, step.X);
+		auto nextColumnCrossing = GetFirstCrossing(start.Y, delta.Y, cell.Y, step.Y);
+		const auto rowCrossingInterval = step.X == 0 ? MAX_flt : 1.f / FMath::Abs(delta.X);
+		const auto columnCrossingInterval = step.Y == 0 ? MAX_flt : 1.f / FMath::Abs(delta.Y);
+		// Counted rather than compared against t, so that rounding can't make the walk miss endCell
+		auto numStepsLeft = FMath::Abs(endCell.X - cell.X) + FMath::Abs(endCell.Y - cell.Y);
+		while (visit(cell) && numStepsLeft-- > 0) {
+			const auto shouldCrossRow = (cell.Y == endCell.Y) || (cell.X != endCell.X && nextRowCrossing < nextColumnCrossing);
+			if (shouldCrossRow) {
+				cell.X += step.X;
+				nextRowCrossing += rowCrossingInterval;
+			}
+			else {
+				cell.Y += step.Y;
+				nextColumnCrossing += columnCrossingInterval;
+			}
+		}
+	}
+
+	// Where the segment first enters the square, as t running from 0 at start to 1 at end; false if it misses.
+	// A segment starting inside the square enters it at 0.
+	static bool IntersectSegmentWithSquare(FVector2D start, FVector2D end, FVector2D center, float halfExtent, float& outEntry)
+	{
+		const auto delta = end - start;
+		auto entry = 0.f;
+		auto exit = 1.f;
+		for (int axis = 0; axis < 2; axis++) {
+			const auto startCoordinate = axis == 0 ? start.X : start.Y;
+			const auto deltaCoordinate = axis == 0 ? delta.X : delta.Y;
+			const auto low = (axis == 0 ? center.X : center.Y) - halfExtent;
+			const auto high = (axis == 0 ? center.X : center.Y) + halfExtent;
+			if (deltaCoordinate == 0.f) {
+				if (startCoordinate < low || high < startCoordinate)
+					return false;
+				continue;
+			}
+			const auto lowCrossing = (low - startCoordinate) / deltaCoordinate;
+			const auto highCrossing = (high - startCoordinate) / deltaCoordinate;
+			entry = FMath::Max(entry, FMath::Min(lowCrossing, highCrossing));
+			exit = FMath::Min(exit, FMath::Max(lowCrossing, highCrossing));
+			if (entry > exit)
+				return false;
+		}
+		outEntry = entry;
+		return true;
+	}
+
+	static FIntPoint ToCell(FVector2D position) { return FIntPoint{ FMath::RoundToInt(position.X), FMath::RoundToInt(position.Y) }; }
+	// Just under half a cell, so that the bodies of blocks resting on neighboring lattice points don't touch
+	constexpr static float BLOCK_HALF_EXTENT = 0.5f - 0.0001f;
+private:
+	static float GetFirstCrossing(float startCoordinate, float delta, int startCell, int step)
+	{
+		if (step == 0)
+			return MAX_flt;
+		const auto border = startCell + 0.5f * step;
+		return (border - startCoordinate) / delta;
+	}
+	bool IsIndexed(FIntPoint cell) const { return (-numRows <= cell.X) && (cell.X < numRows) && (0 <= cell.Y) && (cell.Y < numCols); }
+	int32 ToCellIndex(FIntPoint cell) const { return (cell.X + numRows) * numCols + cell.Y; }
+
+	class Entry {
+	public:
+		int32 blockIndex;
+		// next entry of the same cell
+		int32 next;
+	};
+	int numRows = 0;
+	int numCols = 0;
+	// first entry of each cell, INDEX_NONE for an empty one
+	TArray<int32> cellHeads;
+	TArray<Entry> entries;
+};
@@ -3,45 +3,58 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Containers/ArrayView.h"
 #include "Block.h"
 #include "BlockMatrix.h"
 #include "BlockAction.h"
+#include "BlockRandomGenerator.h"
+#include "BlockHandle.h"
+#include "BlockPhysicsTrace.h"
+#include "BoardHashCache.h"
+#include "ExplosionMask.h"
+#include "SpecialCombo.h"
+#include "BlockOccupancyIndex.h"
 
 class PhysicalBlockSnapShot {
 public:
-	PhysicalBlockSnapShot(int id, Block block, ActionType actionType, FVector2D position) : id(id), block(block), actionType(actionType), position(position) {}
-	int id;
+	PhysicalBlockSnapShot(BlockHandle handle, Block block, ActionType actionType, FVector2D position) : handle(handle), block(block), actionType(actionType), position(position) {}
+	BlockHandle handle;
 	Block block;
 	ActionType actionType;
 	FVector2D position;
 };
 
-class ExplosionArea;
+// What changed between the last two publishes. A reader that skips a tick should resync from GetPublishedSnapShots.
+class PhysicalBlocksDelta {
+public:
+	bool IsEmpty() const { return spawned.Num() == 0 && changed.Num() == 0 && removed.Num() == 0; }
+	void Reset();
+	TArray<PhysicalBlockSnapShot> spawned;
+	// blocks whose block, action type or position differ from their last published snapshot
+	TArray<PhysicalBlockSnapShot> changed;
+	TArray<BlockHandle> removed;
+	// changed blocks that started getting destroyed
+	TArray<PhysicalBlockSnapShot> destroyStarted;
+};
 
 class PhysicalBlock {
 public:
-	PhysicalBlock(Block block, FIntPoint initialPosition);
-	PhysicalBlock(Block block, FIntPoint initialPosition, TUniquePtr<BlockAction>&& action);
+	PhysicalBlock(Block block, FIntPoint initialPosition, BlockHandle handle);
+	PhysicalBlock(Block block, BlockHandle handle, TUniquePtr<BlockAction>&& action);
 	PhysicalBlock(const PhysicalBlock& other) = delete;
 	PhysicalBlock(PhysicalBlock&& other);
-	int GetId() const { return id; }
+	PhysicalBlock& operator=(PhysicalBlock&& other);
+	PhysicalBlock Clone(BlockPhysics& owner) const;
+	BlockHandle GetHandle() const { return handle; }
 	PhysicalBlockSnapShot GetSnapShot() const;
-	TUniquePtr<ExplosionArea> GetExplosionArea(float gridSize) const { return block.GetExplosionArea(currentAction->GetPosition(), gridSize); }
+	bool IsGettingDestroyed() const { return currentAction->GetType() == ActionType::GetsDestroyed; }
 	Block block;
 	TUniquePtr<BlockAction> currentAction;
+	bool wasGettingDestroyedAtTickStart = false;
+	// cell of BlockPhysics' logical grid this block is written to, INDEX_NONE if it isn't eligible for matching
+	int32 logicalGridIndex = INDEX_NONE;
 private:
-	int id;
-	static int lastIssuedId;
-};
-
-class PhysicalBlocksSnapShotDiff {
-public:
-	PhysicalBlocksSnapShotDiff(const TArray<PhysicalBlockSnapShot>& before, const TArray<PhysicalBlockSnapShot>& after);
-	TSet<int> GetJustDestroyedBlockIds() const;
-private:
-	bool WasNotDestroyingBefore(int blockId) const;
-	TArray<PhysicalBlockSnapShot> before;
-	TArray<PhysicalBlockSnapShot> after;
+	BlockHandle handle;
 };
 
 class BlockMatrix;
@@ -49,10 +62,18 @@ class BlockMatrix;
 class TDDPRACTICE3MATCH_API BlockPhysics
 {
 public:
-	explicit BlockPhysics(const BlockMatrix& blockMatrix, TFunction<int(void)> newBlockGenerator = rand, TFunction<int(void)> randomDirectionGenerator = rand);
+	explicit BlockPhysics(const BlockMatrix& blockMatrix, uint64 randomSeed = BlockRandomGenerator::DEFAULT_SEED);
+	// Test injection: a null generator falls back to the board's own random generator.
+	BlockPhysics(const BlockMatrix& blockMatrix, TFunction<int(void)> newBlockGenerator, TFunction<int(void)> randomDirectionGenerator = nullptr);
 	BlockPhysics(const BlockPhysics& other) = delete;
 	BlockPhysics(BlockPhysics&& other);
 	~BlockPhysics();
+	// Independent copy of the whole board, in-flight actions and random state included, for lookahead.
+	// The clone has no trace, so branching stays cheap.
+	BlockPhysics Clone() const;
+private:
+	class CloneTag {};
+	BlockPhysics(const BlockPhysics& other, CloneTag);
 
 public:
 	void Tick(float deltaSeconds);
@@ -60,28 +81,55 @@ public:
 	int GetNumDestroyedBlocksInThisTick() const {
 		return numDestroyedBlocksInThisTick;
 	}
+	// Destroyed blocks plus the formations matched in this tick
+	int GetScoreInThisTick() const;
+	constexpr static int SCORE_PER_DESTROYED_BLOCK = 50;
 private:
 	void TickBlockActions(float deltaSeconds);
+	// Applies the roll over effect along the cells each rollable swept in this tick.
+	void ResolveRolls();
+	void ApplyRollOverEffectAt(FIntPoint cell, BlockHandle rollableHandle, FIntPoint rollingDirection);
 	bool ShouldCheckMatch();
+	// true once the board has settled, when the logical grid holds every block
+	bool AreAllBlocksEligibleForMatching() const;
 	bool CheckAndProcessMatch();
+	// Swapped pairs with a SpecialCombo set it off instead of going through the match check.
+	// Cell effects of the combos go into comboMask, to be applied in one pass.
+	bool ResolveSwipedSpecials();
+	static bool IsJustSwiped(const PhysicalBlock& physicalBlock);
+	PhysicalBlock* FindSwipePartner(const PhysicalBlock& swipedBlock);
 	TSet<FIntPoint> GetBlockInflowPositions();
-	void RecursivelyApplyExplosionEffects(const TSet<int>& destroyedBlockIds);
-	TSet<int> DestroyBlocksAndGetTheirIds(const ExplosionArea& explosionArea);
+	void RecursivelyApplyExplosionEffects(const TSet<BlockHandle>& destroyedBlockHandles);
+	TSet<BlockHandle> DestroyBlocksAndGetTheirHandles(const ExplosionMask& explosionMask);
+	// The color with the most blocks among those the mask doesn't clear yet; NONE if there's none left
+	BlockColor GetMostCommonColorNotIn(const ExplosionMask& explosionMask) const;
 	void RemoveDeadBlocks();
 	void ChangeCompletedActionsToNextActions(bool thereIsAMatch);
 	void SetFallingActionsAndGenerateNewBlocks();
 	TSet<Match> matchesOccuredInThisTick;
-	int numDestroyedBlocksInThisTick;
-	TSet<int> blockIdsThatShouldNotTick;
+	int numDestroyedBlocksInThisTick = 0;
+	// Blocks used up by a combo in this tick; their own explosions don't go off.
+	TSet<BlockHandle> comboConsumedBlockHandles;
+	ExplosionMask comboMask;
+	void MarkBlocksGettingDestroyedAtTickStart();
+	TSet<BlockHandle> GetBlockHandlesJustStartedGettingDestroyed() const;
+	int CountBlocksJustStartedGettingDestroyed() const;
+	void PublishSnapShots();
 
 public:
 	void ReceiveSwipeInput(FIntPoint swipeStart, FIntPoint swipeEnd);
 
 	void DisableTickDebugLog() { enableTickDebugLog = false; }
+	// Echoes trace events as text to LogBlockPhysics at Verbose
 	bool enableTickDebugLog = true;
 
+#if BLOCK_PHYSICS_TRACE_ENABLED
+	// Use through BLOCK_PHYSICS_TRACE so that the call compiles out with the trace.
+	void RecordTrace(BlockTraceEventType eventType, const PhysicalBlock* block, FVector2D position, FVector2D argument = FVector2D::ZeroVector);
+	const BlockPhysicsTrace* GetTrace() const { return trace.Get(); }
+#endif
+
 	constexpr static int MAX_ROW_COL_SIZE = 50;
-	constexpr static float DELTA_COSINE = 0.001f;
 	constexpr static float DELTA_DISTANCE = 0.0001f;
 	constexpr static float GRID_SIZE = 1.0f;
 	constexpr static float GRAVITY_ACCELERATION = 10.0f;
@@ -89,42 +137,112 @@ public:
 	constexpr static float ROLL_SPEED = SWIPE_MOVE_SPEED;
 	constexpr static float DESTROY_ANIMATION_TIME = 0.35f;
 
+	// Versioned little-endian image of the whole board, in-flight actions and random state included.
+	// Per-tick results and injected generators aren't part of it.
+	void SaveState(TArray<uint8>& outBytes) const;
+	// Returns false and leaves the board as it was if the bytes aren't a state this version can read.
+	bool LoadState(const TArray<uint8>& bytes);
+	constexpr static uint32 STATE_MAGIC = 0x54535042;
+	constexpr static uint32 STATE_VERSION = 1;
+
+	void SetRandomSeed(uint64 randomSeed) { randomGenerator.Seed(randomSeed); }
+	BlockRandomGeneratorState GetRandomState() const { return randomGenerator.GetState(); }
+	void SetRandomState(const BlockRandomGeneratorState& randomState) { randomGenerator.SetState(randomState); }
+
 	bool IsEmpty(FIntPoint position) const;
+	// Whether a block's position lies on the segment, ends included. Costs the cells the segment crosses.
 	bool ExistsBlockBetween(FIntPoint startPos, FIntPoint endPos) const;
+	// The block whose body the segment enters first, or an invalid snapshot if there's none.
+	// Bodies are unit squares around the blocks' positions, so the segment needn't run along the lattice.
+	PhysicalBlockSnapShot FindFirstBlockOnSegment(FVector2D start, FVector2D end) const;
+	PhysicalBlockSnapShot FindFirstBlockOnRay(FVector2D origin, FVector2D direction, float maxDistance) const;
 	bool ExistsBlockNear(FIntPoint searchPosition, float threshold) const;
 	bool IsPlayingDestroyAnimAt(FIntPoint position) const;
 	bool IsIdleAt(FIntPoint position) const;
 	bool IsInAction() const;
 
-	void ApplyRollOverEffectAt(const TSet<FIntPoint>& destroyPositions, const TSet<int>& exceptionalBlockIds, FIntPoint rollingDirection);
-
 	PhysicalBlockSnapShot GetTopmostBlockSnapShotAt(FIntPoint position) const;
+	// O(1); returns an invalid snapshot if the block has been removed
+	PhysicalBlockSnapShot GetBlockSnapShot(BlockHandle handle) const;
+	// Copies the live state; per-frame readers should use GetPublishedSnapShots instead.
 	TArray<PhysicalBlockSnapShot> GetPhysicalBlockSnapShots() const;
-	BlockMatrix GetBlockMatrix() const;
+	// Snapshots of all blocks as of the end of the last Tick (or construction). The view stays valid through the next Tick.
+	TArrayView<const PhysicalBlockSnapShot> GetPublishedSnapShots() const { return publishedSnapShots[publishedBufferIndex]; }
+	// Valid until the next Tick, like the published snapshots.
+	const PhysicalBlocksDelta& GetPublishedDelta() const { return publishedDelta; }
+	// Blocks eligible for matching, kept up to date as actions change rather than rebuilt per call
+	const BlockMatrix& GetBlockMatrix() const { return logicalGrid; }
+	// Zobrist hash of the logical grid; covers every block once the board is settled
+	uint64 GetBoardHash() const { return logicalGrid.GetHash(); }
+	// Match checks of settled boards look the grid up here before scanning it. Clones share the cache, across threads too, hence the thread-safe pointer.
+	void SetMatchCache(TSharedPtr<BoardHashCache<TSet<Match>>, ESPMode::ThreadSafe> newMatchCache) { matchCache = newMatchCache; }
 	int GetNumRows() const { return numRows; }
 	int GetNumCols() const { return numCols; }
+	// blocks getting destroyed and blocks still falling in included
+	int GetNumBlocksOfColor(BlockColor color) const;
 
 	static FIntPoint ToFIntPoint(FVector2D position);
 	static bool IsNearLatticePoint(FVector2D position);
 
 private:
+	PhysicalBlock& SpawnPhysicalBlock(Block block, FIntPoint initialPosition);
+	const PhysicalBlock* FindBlock(BlockHandle handle) const;
+	PhysicalBlock* FindBlock(BlockHandle handle);
 	const PhysicalBlock* GetTopmostBlockAt(FIntPoint position) const;
 	PhysicalBlock* GetTopmostBlockAt(FIntPoint position);
-	TArray<PhysicalBlock*> GetBlocksAt(FIntPoint position);
+	// Treats each block as a square of the given half extent around its position
+	const PhysicalBlock* FindFirstPhysicalBlockOnSegment(FVector2D start, FVector2D end, float blockHalfExtent) const;
+	const BlockOccupancyIndex& GetOccupancyIndex() const;
+	void RebuildOccupancyIndex() const;
 
 	void StartDestroyingMatchedBlocksAccordingTo(const MatchResult& blockMatrix);
 	void SetSpecialBlocksSpawnAccordingTo(const MatchResult& blockMatrix);
 
 	void MakeBlockFallToDestination(PhysicalBlock& blockStatus, FIntPoint destination);
+	// Every action change goes through here so that the logical grid stays in sync.
+	void SetAction(PhysicalBlock& physicalBlock, TUniquePtr<BlockAction>&& action);
+	void SyncLogicalGrid(PhysicalBlock& physicalBlock);
+	void ClearLogicalGridCell(PhysicalBlock& physicalBlock);
+	void RebuildLogicalGrid();
+	// Every block change goes through here so that the per-color index stays in sync.
+	void SetBlock(PhysicalBlock& physicalBlock, Block block);
+	void TintOneColorClearSwipedWith(PhysicalBlock& swipedBlock, const PhysicalBlock& otherBlock);
+	static int GetColorIndex(BlockColor color);
+	void AddToColorIndex(const PhysicalBlock& physicalBlock);
+	void RemoveFromColorIndex(const PhysicalBlock& physicalBlock);
+	void RebuildColorIndex();
 
 	static int ToInt(float value);
-	Block GetRandomBlock();
+	void GenerateRefillColorIndices(int count);
 	FIntPoint GetRandomOrthogonalDirectionFrom(FIntPoint direction);
 
 	TArray<PhysicalBlock> physicalBlocks;
+	BlockHandleTable handleTable;
 	int numRows = 0;
 	int numCols = 0;
+	BlockMatrix logicalGrid;
+	// handle of the block each logical grid cell was written by
+	TArray<BlockHandle> logicalGridOwners;
+	// handles of the blocks of each of validColors, so that clearing a color doesn't scan the board
+	TArray<TSet<BlockHandle>> blockHandlesPerColor;
 	float elapsedTime = 0.0f;
+	BlockRandomGenerator randomGenerator;
+	TArray<int32> refillColorIndices;
+	// Scratch buffer kept across ticks so that a settled board ticks without allocating
+	TArray<PhysicalBlock*> blocksInColumn;
+	// Rebuilt on the first query after blocks moved, were added or removed, or changed actions
+	mutable BlockOccupancyIndex occupancyIndex;
+	mutable bool isOccupancyIndexStale = true;
+	ExplosionMask explosionMask;
+	TArray<PhysicalBlockSnapShot> publishedSnapShots[2];
+	int32 publishedBufferIndex = 0;
+	// Last published snapshot of each handle slot; an invalid handle marks a slot with nothing published.
+	TArray<PhysicalBlockSnapShot> lastPublishedSnapShotPerSlot;
+	PhysicalBlocksDelta publishedDelta;
 	TFunction<int(void)> newBlockGenerator;
 	TFunction<int(void)> randomDirectionGenerator;
+	TSharedPtr<BoardHashCache<TSet<Match>>, ESPMode::ThreadSafe> matchCache;
+#if BLOCK_PHYSICS_TRACE_ENABLED
+	TUniquePtr<BlockPhysicsTrace> trace;
+#endif
 };
@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "BlockPhysicsBenchCommandlet.generated.h"
+
+/**
+ * Runs BlockPhysics headless over fixed-seed workloads and writes timings as JSON.
+ * UE4Editor-Cmd <Project> -run=BlockPhysicsBench -nullrhi [-Sizes=5,10,20,50] [-Swipes=20] [-Seed=1] [-Output=<path>]
+ */
+UCLASS()
+class TDDPRACTICE3MATCH_API UBlockPhysicsBenchCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UBlockPhysicsBenchCommandlet();
+	virtual int32 Main(const FString& Params) override;
+};
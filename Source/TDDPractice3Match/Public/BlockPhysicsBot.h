@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BlockPhysics.h"
+
+class BlockSwipe {
+public:
+	BlockSwipe(FIntPoint start, FIntPoint end) : start(start), end(end) {}
+	bool operator==(const BlockSwipe& other) const { return (start == other.start) && (end == other.end); }
+	FIntPoint start;
+	FIntPoint end;
+};
+
+class SwipeEvaluation {
+public:
+	SwipeEvaluation(BlockSwipe swipe) : swipe(swipe) {}
+	float GetExpectedScore() const { return numRollouts == 0 ? 0.f : static_cast<float>(totalScore) / numRollouts; }
+	BlockSwipe swipe;
+	int64 totalScore = 0;
+	int32 numRollouts = 0;
+};
+
+// Monte Carlo evaluation of the swipes on a settled board, for auto-play, hints and level balancing.
+// Each rollout clones the board, reseeds its refills and resolves the cascade logically: ticks are long enough
+// for every animation to finish in one step, so a rollout costs a handful of ticks instead of dozens.
+// Boards with injected generators shouldn't be evaluated, since rollouts run on worker threads.
+class TDDPRACTICE3MATCH_API BlockPhysicsBot {
+public:
+	explicit BlockPhysicsBot(uint64 seed = BlockRandomGenerator::DEFAULT_SEED);
+	// Swipes between idle blocks, plus munchicken rolls in every direction. Empty while the board is in action.
+	static TArray<BlockSwipe> GetAvailableSwipes(const BlockPhysics& blockPhysics);
+	// Runs rounds of ROLLOUTS_PER_ROUND rollouts per swipe in parallel until the time budget is spent or maxRounds have run.
+	// Rollouts due to start past the deadline are skipped, so on a big board even the first round may end partway.
+	// Results are deterministic for a given seed as long as every round runs to its end.
+	TArray<SwipeEvaluation> EvaluateSwipes(const BlockPhysics& blockPhysics, double timeBudgetSeconds, int maxRounds = MAX_int32) const;
+	// returns the score of the whole cascade the swipe sets off
+	int RollOut(const BlockPhysics& blockPhysics, const BlockSwipe& swipe, uint64 rolloutSeed) const;
+
+	constexpr static float LOGICAL_TICK_SECONDS = 1.0f;
+	constexpr static int MAX_TICKS_PER_ROLLOUT = 256;
+	constexpr static int ROLLOUTS_PER_ROUND = 32;
+private:
+	uint64 seed;
+	// Rollouts keep revisiting the same settled boards, so match sets and swipe lists are cached by board hash.
+	// The caches are sharded, so that the rollouts of parallel workers rarely contend for a lock.
+	TSharedPtr<BoardHashCache<TSet<Match>>, ESPMode::ThreadSafe> matchCache;
+	TSharedPtr<BoardHashCache<TArray<BlockSwipe>>, ESPMode::ThreadSafe> swipeCache;
+};
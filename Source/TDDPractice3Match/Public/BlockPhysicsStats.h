@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+// Shown with `stat BlockPhysics`; the same phases are written per frame with `csvprofile start`.
+DECLARE_STATS_GROUP(TEXT("BlockPhysics"), STATGROUP_BlockPhysics, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Tick"), STAT_BlockPhysicsTick, STATGROUP_BlockPhysics, TDDPRACTICE3MATCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Tick actions"), STAT_BlockPhysicsTickActions, STATGROUP_BlockPhysics, TDDPRACTICE3MATCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Check match"), STAT_BlockPhysicsCheckMatch, STATGROUP_BlockPhysics, TDDPRACTICE3MATCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Resolve explosions"), STAT_BlockPhysicsResolveExplosions, STATGROUP_BlockPhysics, TDDPRACTICE3MATCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Remove dead blocks"), STAT_BlockPhysicsRemoveDeadBlocks, STATGROUP_BlockPhysics, TDDPRACTICE3MATCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Change actions"), STAT_BlockPhysicsChangeActions, STATGROUP_BlockPhysics, TDDPRACTICE3MATCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Fall and refill"), STAT_BlockPhysicsFallAndRefill, STATGROUP_BlockPhysics, TDDPRACTICE3MATCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update block actors"), STAT_BlockPhysicsUpdateBlockActors, STATGROUP_BlockPhysics, TDDPRACTICE3MATCH_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Blocks ticked"), STAT_BlockPhysicsBlocksTicked, STATGROUP_BlockPhysics, TDDPRACTICE3MATCH_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Matches found"), STAT_BlockPhysicsMatchesFound, STATGROUP_BlockPhysics, TDDPRACTICE3MATCH_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Action allocations"), STAT_BlockPhysicsActionAllocations, STATGROUP_BlockPhysics, TDDPRACTICE3MATCH_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Block actors spawned"), STAT_BlockPhysicsActorsSpawned, STATGROUP_BlockPhysics, TDDPRACTICE3MATCH_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Block actors destroyed"), STAT_BlockPhysicsActorsDestroyed, STATGROUP_BlockPhysics, TDDPRACTICE3MATCH_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Block actor pool hits"), STAT_BlockPhysicsActorPoolHits, STATGROUP_BlockPhysics, TDDPRACTICE3MATCH_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Block actor pool misses"), STAT_BlockPhysicsActorPoolMisses, STATGROUP_BlockPhysics, TDDPRACTICE3MATCH_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(TDDPRACTICE3MATCH_API, BlockPhysics);
+
+// Times a scope both as a cycle stat and as a CSV timing stat named after the phase.
+// Declares the timers in the enclosing scope, so it has to stand in a braced block of its own, never under a bare if.
+#define BLOCK_PHYSICS_SCOPED_STAT(PhaseName) \
+	SCOPE_CYCLE_COUNTER(STAT_BlockPhysics##PhaseName); \
+	CSV_SCOPED_TIMING_STAT(BlockPhysics, PhaseName)
+
+// Increments a counter stat and accumulates the same amount into this frame's CSV row. A single statement, safe under an if.
+#define BLOCK_PHYSICS_COUNT(CounterName, Amount) \
+	do { \
+		INC_DWORD_STAT_BY(STAT_BlockPhysics##CounterName, Amount); \
+		CSV_CUSTOM_STAT(BlockPhysics, CounterName, static_cast<int32>(Amount), ECsvCustomStatOp::Accumulate); \
+	} while (0)
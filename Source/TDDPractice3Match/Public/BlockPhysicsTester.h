@@ -11,7 +11,7 @@ class BlockPhysics;
 class TDDPRACTICE3MATCH_API BlockPhysicsTester
 {
 public:
-	explicit BlockPhysicsTester(const BlockMatrix& initialBlockMatrix, TFunction<int(void)> randomGeneratorForNewBlock = rand, TFunction<int(void)> randomGeneratorForDirection = rand);
+	explicit BlockPhysicsTester(const BlockMatrix& initialBlockMatrix, TFunction<int(void)> randomGeneratorForNewBlock = nullptr, TFunction<int(void)> randomGeneratorForDirection = nullptr);
 
 	void DoSwipe(const FIntPoint& swipeStart, const FIntPoint& swipeEnd) const;
 
@@ -41,6 +41,11 @@ public:
 	void TestIfCorrectlyGettingDestroyed(const TSet<FIntPoint>& onlyPositionsThatShouldBeDestroyed) const;
 	void TestIsInAction(bool expectedValue) const;
 
+	// Once started, heap allocations of every BlockPhysics::Tick done through this tester are counted.
+	void StartTrackingAllocations();
+	void TestAllocationsPerTickWithin(uint64 maxAllocations, uint64 maxAllocatedBytes) const;
+	void TestGetMatchesAllocationsWithin(uint64 maxAllocations, uint64 maxAllocatedBytes) const;
+
 private:
 	void TickFor(float deltaSeconds);
 
@@ -53,5 +58,10 @@ private:
 
 	int tickDivider = 1;
 
+	bool isTrackingAllocations = false;
+	int numTrackedTicks = 0;
+	uint64 maxAllocationsPerTick = 0;
+	uint64 maxAllocatedBytesPerTick = 0;
+
 	constexpr static float VERY_SHORT_TIME = 0.00001f;
 };
@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogBlockPhysics, Log, All);
+
+#ifndef BLOCK_PHYSICS_TRACE_ENABLED
+#define BLOCK_PHYSICS_TRACE_ENABLED !UE_BUILD_SHIPPING
+#endif
+
+#if BLOCK_PHYSICS_TRACE_ENABLED
+#define BLOCK_PHYSICS_TRACE(Physics, EventType, ...) (Physics).RecordTrace(BlockTraceEventType::EventType, ##__VA_ARGS__)
+#else
+#define BLOCK_PHYSICS_TRACE(Physics, EventType, ...)
+#endif
+
+// When this enum gets updated, BlockPhysicsTraceDecoder should be too.
+enum class BlockTraceEventType : uint8 {
+	TickStart,
+	ActionCompleted,
+	MatchChecked,
+	MatchedBlockDestroyStarted,
+	SpecialBlockSpawnReserved,
+	FallStarted,
+	BlockGenerated,
+	ColumnFull,
+	RolledOver,
+	RollableTriggered,
+	DestroyedInBackground
+};
+
+// Positions are stored as fixed point with POSITION_SCALE steps per cell, so a record stays 20 bytes.
+class BlockTraceRecord {
+public:
+	float elapsedTime = 0.f;
+	BlockTraceEventType eventType = BlockTraceEventType::TickStart;
+	// color in the low nibble, special attribute in the high nibble
+	uint8 blockCode = 0;
+	uint8 actionType = 0;
+	uint8 reserved = 0;
+	int32 handleIndex = INDEX_NONE;
+	int16 positionX = 0;
+	int16 positionY = 0;
+	int16 argumentX = 0;
+	int16 argumentY = 0;
+
+	constexpr static float POSITION_SCALE = 100.f;
+};
+static_assert(sizeof(BlockTraceRecord) == 20, "BlockTraceRecord should stay a fixed 20 byte record");
+
+// Single producer (the board's tick) ring buffer. Readers on any thread copy out records without locking and
+// drop whatever the producer overwrote while they were copying.
+class TDDPRACTICE3MATCH_API BlockPhysicsTrace {
+public:
+	void Record(const BlockTraceRecord& record);
+	void CopyRecords(TArray<BlockTraceRecord>& outRecords) const;
+	uint32 GetNumRecordedTotal() const { return writeCursor.Load(); }
+
+	constexpr static uint32 CAPACITY = 4096;
+private:
+	static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY should be a power of two");
+	BlockTraceRecord records[CAPACITY];
+	TAtomic<uint32> writeCursor{ 0 };
+};
@@ -0,0 +1,14 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BlockPhysicsTrace.h"
+
+// Turns binary trace records into text. Only meant to run on demand, never inside the tick.
+namespace BlockPhysicsTraceDecoder
+{
+	TDDPRACTICE3MATCH_API FString ToText(BlockTraceEventType eventType);
+	TDDPRACTICE3MATCH_API FString ToText(const BlockTraceRecord& record);
+	TDDPRACTICE3MATCH_API TArray<FString> ToText(const BlockPhysicsTrace& trace);
+};
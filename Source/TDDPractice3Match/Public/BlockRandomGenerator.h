@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class BlockRandomGeneratorState {
+public:
+	bool operator==(const BlockRandomGeneratorState& other) const;
+	bool operator!=(const BlockRandomGeneratorState& other) const { return !(*this == other); }
+	uint32 words[4] = { 0, 0, 0, 0 };
+};
+
+// xoshiro128** owned by a single board, so boards never share (or race on) random state.
+class TDDPRACTICE3MATCH_API BlockRandomGenerator {
+public:
+	explicit BlockRandomGenerator(uint64 seed = DEFAULT_SEED) { Seed(seed); }
+	void Seed(uint64 seed);
+	uint32 Next();
+	// Unbiased integer in [0, bound)
+	int32 NextInRange(int32 bound);
+	void FillInRange(int32 bound, int32 count, TArray<int32>& outValues);
+	BlockRandomGeneratorState GetState() const { return state; }
+	void SetState(const BlockRandomGeneratorState& newState) { state = newState; }
+
+	constexpr static uint64 DEFAULT_SEED = 0x3A7C1E5D2B9F4806ull;
+private:
+	BlockRandomGeneratorState state;
+};
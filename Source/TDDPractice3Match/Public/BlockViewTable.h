@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BlockHandle.h"
+#include "BlockAction.h"
+#include "BlockPhysics.h"
+
+class AActor;
+
+// What the controller draws for each block, in a slot per handle index so that finding it is an array access.
+// A slot holding a handle of another generation belongs to a block that is gone.
+// A delta marks slots dirty; reconciling them walks the dirty slots in index order.
+class TDDPRACTICE3MATCH_API BlockViewTable {
+public:
+	enum DirtyFlag : uint8 {
+		Spawned = 1 << 0,
+		Changed = 1 << 1,
+		Removed = 1 << 2
+	};
+
+	class Slot {
+	public:
+		bool IsDirty(DirtyFlag flag) const { return (dirtyFlags & flag) != 0; }
+		// Forgets what is drawn, leaving the dirty state to the walk
+		void Vacate();
+
+		// the block drawn in the slot, INVALID if none
+		BlockHandle handle;
+		AActor* actor = nullptr;
+		int actorKind = INDEX_NONE;
+		// as last drawn
+		ActionType actionType = ActionType::Invalid;
+
+		// latest snapshot of a spawned or changed block, pointing into the delta that marked it
+		const PhysicalBlockSnapShot* pending = nullptr;
+		uint8 dirtyFlags = 0;
+	};
+
+	void Reset();
+	// Makes the slot draw the block, growing the table to reach its index
+	Slot& Occupy(BlockHandle handle);
+	// nullptr unless the handle's block is drawn
+	Slot* Find(BlockHandle handle);
+	// The delta has to outlive the next ForEachDirty
+	void MarkDirty(const PhysicalBlocksDelta& delta);
+	int GetNumDirty() const { return dirtySlotIndices.Num(); }
+	int GetNumSlots() const { return slots.Num(); }
+
+	// Visits each dirty slot once, in index order, then clears its dirty state
+	template <typename Visitor>
+	void ForEachDirty(Visitor visit)
+	{
+		dirtySlotIndices.Sort();
+		for (const auto slotIndex : dirtySlotIndices) {
+			auto& slot = slots[slotIndex];
+			visit(slot);
+			slot.pending = nullptr;
+			slot.dirtyFlags = 0;
+		}
+		dirtySlotIndices.Reset();
+	}
+
+private:
+	Slot& GetSlot(int32 slotIndex);
+	void MarkDirty(int32 slotIndex, DirtyFlag flag);
+
+	TArray<Slot> slots;
+	TArray<int32> dirtySlotIndices;
+};
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/ScopeLock.h"
+
+// Bounded map from board hashes to results computed from those boards. When full, it evicts with the clock
+// algorithm, so entries hit since the hand last passed get a second chance.
+// Split into shards by hash, each with its own lock, so that parallel rollouts sharing one rarely wait on each other.
+// Values are immutable and shared, so a hit only copies a pointer under the lock.
+template<typename ValueType>
+class BoardHashCache {
+public:
+	using ValuePtr = TSharedPtr<const ValueType, ESPMode::ThreadSafe>;
+
+	explicit BoardHashCache(int32 capacity = DEFAULT_CAPACITY, int32 numShards = DEFAULT_NUM_SHARDS)
+	{
+		const auto clampedNumShards = FMath::Clamp(numShards, 1, FMath::Max(capacity, 1));
+		for (int i = 0; i < clampedNumShards; i++) {
+			shards.Add(MakeUnique<Shard>());
+			shards.Last()->capacity = FMath::Max(capacity / clampedNumShards, 1);
+		}
+	}
+
+	// nullptr on a miss
+	ValuePtr Find(uint64 hash)
+	{
+		auto& shard = GetShard(hash);
+		FScopeLock scopeLock(&shard.lock);
+		const auto* entryIndex = shard.hashToEntryIndex.Find(hash);
+		if (entryIndex == nullptr)
+			return nullptr;
+		auto& entry = shard.entries[*entryIndex];
+		entry.referenced = true;
+		return entry.value;
+	}
+
+	void Add(uint64 hash, ValueType value)
+	{
+		// built before taking the lock
+		auto sharedValue = ValuePtr(MakeShared<const ValueType, ESPMode::ThreadSafe>(MoveTemp(value)));
+		auto& shard = GetShard(hash);
+		FScopeLock scopeLock(&shard.lock);
+		shard.Add(hash, MoveTemp(sharedValue));
+	}
+
+	int32 Num() const
+	{
+		auto ret = 0;
+		for (const auto& shard : shards) {
+			FScopeLock scopeLock(&shard->lock);
+			ret += shard->entries.Num();
+		}
+		return ret;
+	}
+
+	constexpr static int32 DEFAULT_CAPACITY = 4096;
+	constexpr static int32 DEFAULT_NUM_SHARDS = 16;
+private:
+	class Entry {
+	public:
+		uint64 hash;
+		ValuePtr value;
+		bool referenced;
+	};
+	class Shard {
+	public:
+		void Add(uint64 hash, ValuePtr&& value)
+		{
+			if (const auto* entryIndex = hashToEntryIndex.Find(hash)) {
+				entries[*entryIndex].value = MoveTemp(value);
+				return;
+			}
+			if (entries.Num() < capacity) {
+				hashToEntryIndex.Add(hash, entries.Add(Entry{ hash, MoveTemp(value), false }));
+				return;
+			}
+			while (entries[clockHand].referenced) {
+				entries[clockHand].referenced = false;
+				clockHand = (clockHand + 1) % capacity;
+			}
+			auto& victim = entries[clockHand];
+			hashToEntryIndex.Remove(victim.hash);
+			victim = Entry{ hash, MoveTemp(value), false };
+			hashToEntryIndex.Add(hash, clockHand);
+			clockHand = (clockHand + 1) % capacity;
+		}
+
+		TArray<Entry> entries;
+		TMap<uint64, int32> hashToEntryIndex;
+		int32 clockHand = 0;
+		int32 capacity = 1;
+		mutable FCriticalSection lock;
+	};
+	// The low bits of a Zobrist hash are as random as any, and the map within the shard uses them too, so shard by the high ones.
+	Shard& GetShard(uint64 hash) { return *shards[(hash >> 48) % shards.Num()]; }
+
+	// each behind a pointer, since locks can't be moved
+	TArray<TUniquePtr<Shard>> shards;
+};
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Block.h"
+
+// Cells hit by explosions, rasterized over the board as whole rows, whole columns and single cells (stencils),
+// plus the colors cleared wherever their blocks are.
+// All explosions of a wave are added to one mask, so that blocks are tested against it in a single pass.
+class TDDPRACTICE3MATCH_API ExplosionMask {
+public:
+	ExplosionMask() {}
+	ExplosionMask(int numRows, int numCols) { Reset(numRows, numCols); }
+	// Clears the mask, keeping its memory when the size doesn't change
+	void Reset(int newNumRows, int newNumCols);
+	void AddRow(int row);
+	void AddColumn(int col);
+	// Cells off the board are clipped
+	void AddCell(FIntPoint cell);
+	void AddDiamond(FIntPoint center, int radius);
+	// Colors other than validColors are ignored
+	void AddColor(BlockColor color);
+	// Cells off the board, like those of blocks still falling in, are only hit through their row or column.
+	bool Contains(FIntPoint cell) const;
+	bool IsInAnyLine(FIntPoint cell) const;
+	bool ContainsColor(BlockColor color) const { return (colorMask & GetColorBit(color)) != 0; }
+	bool ContainsAnyLine() const { return containsAnyLine; }
+	// Cells added one by one, each once, so that they can be visited without testing every cell of the board
+	const TArray<FIntPoint>& GetCells() const { return cells; }
+	bool IsEmpty() const { return !containsAnyLine && cells.Num() == 0 && colorMask == 0; }
+	int GetNumRows() const { return numRows; }
+	int GetNumCols() const { return numCols; }
+
+	// Offsets within the given Manhattan distance of the center, built once for every radius up to MAX_DIAMOND_RADIUS
+	static const TArray<FIntPoint>& GetDiamondStencil(int radius);
+	constexpr static int MAX_DIAMOND_RADIUS = 8;
+private:
+	bool IsRowInBoard(int row) const { return (0 <= row) && (row < numRows); }
+	bool IsColumnInBoard(int col) const { return (0 <= col) && (col < numCols); }
+	static uint32 GetColorBit(BlockColor color) { return validColors.Contains(color) ? (1u << static_cast<uint32>(color)) : 0u; }
+
+	int numRows = 0;
+	int numCols = 0;
+	TBitArray<> rowMask;
+	TBitArray<> columnMask;
+	// row-major
+	TBitArray<> cellMask;
+	TArray<FIntPoint> cells;
+	uint32 colorMask = 0;
+	bool containsAnyLine = false;
+};
@@ -5,7 +5,7 @@
 
 struct TDDPRACTICE3MATCH_API Formation {
 	Formation(const TArray<FIntPoint>& vectors, BlockSpecialAttribute specialBlock = BlockSpecialAttribute::NONE) : vectors(vectors), specialBlock(specialBlock) {};
-	bool NeedSpecialBlockSpawn() const { return vectors.Num() == 4; };
+	bool NeedSpecialBlockSpawn() const { return specialBlock != BlockSpecialAttribute::NONE; };
 	BlockSpecialAttribute GetBlockSpecialAttribute() const { return specialBlock; };
 	int GetScore() const { return 100 * vectors.Num(); }
 	bool operator==(const Formation& other) const;
@@ -20,6 +20,9 @@ public:
 	const static TArray<Formation> threeBlockLineFormations;
 	const static TArray<Formation> fourBlockSquareFormations;
 	const static TArray<Formation> fourBlockLineFormations;
+	const static TArray<Formation> fiveBlockLineFormations;
+	const static TArray<Formation> fiveBlockLShapeFormations;
+	const static TArray<Formation> fiveBlockTShapeFormations;
 
 	const static TArray<TArray<Formation>> rules;
 };
@@ -41,8 +44,35 @@ __declspec(selectany) const TArray<Formation> MatchRules::fourBlockLineFormation
 	Formation({{0,1}, {0,0}, {0,-1}, {0,-2}}, BlockSpecialAttribute::VERTICAL_LINE_CLEAR)
 };
 
+__declspec(selectany) const TArray<Formation> MatchRules::fiveBlockLineFormations =
+{
+	Formation({{2,0}, {1,0}, {0,0}, {-1,0}, {-2,0}}, BlockSpecialAttribute::ONE_COLOR_CLEAR),
+	Formation({{0,2}, {0,1}, {0,0}, {0,-1}, {0,-2}}, BlockSpecialAttribute::ONE_COLOR_CLEAR)
+};
+
+// anchored at the corner
+__declspec(selectany) const TArray<Formation> MatchRules::fiveBlockLShapeFormations =
+{
+	Formation({{0,0}, {1,0}, {2,0}, {0,1}, {0,2}}, BlockSpecialAttribute::DIAMOND_NEIGHBORHOOD_CLEAR),
+	Formation({{0,0}, {1,0}, {2,0}, {0,-1}, {0,-2}}, BlockSpecialAttribute::DIAMOND_NEIGHBORHOOD_CLEAR),
+	Formation({{0,0}, {-1,0}, {-2,0}, {0,1}, {0,2}}, BlockSpecialAttribute::DIAMOND_NEIGHBORHOOD_CLEAR),
+	Formation({{0,0}, {-1,0}, {-2,0}, {0,-1}, {0,-2}}, BlockSpecialAttribute::DIAMOND_NEIGHBORHOOD_CLEAR)
+};
+
+// anchored where the stem meets the bar
+__declspec(selectany) const TArray<Formation> MatchRules::fiveBlockTShapeFormations =
+{
+	Formation({{0,-1}, {0,0}, {0,1}, {1,0}, {2,0}}, BlockSpecialAttribute::DIAMOND_NEIGHBORHOOD_CLEAR),
+	Formation({{0,-1}, {0,0}, {0,1}, {-1,0}, {-2,0}}, BlockSpecialAttribute::DIAMOND_NEIGHBORHOOD_CLEAR),
+	Formation({{-1,0}, {0,0}, {1,0}, {0,1}, {0,2}}, BlockSpecialAttribute::DIAMOND_NEIGHBORHOOD_CLEAR),
+	Formation({{-1,0}, {0,0}, {1,0}, {0,-1}, {0,-2}}, BlockSpecialAttribute::DIAMOND_NEIGHBORHOOD_CLEAR)
+};
+
 __declspec(selectany) const TArray<TArray<Formation>> MatchRules::rules =
 {
+	fiveBlockLineFormations,
+	fiveBlockLShapeFormations,
+	fiveBlockTShapeFormations,
 	fourBlockLineFormations,
 	fourBlockSquareFormations,
 	threeBlockLineFormations
@@ -4,6 +4,11 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/PlayerController.h"
+#include "BlockHandle.h"
+#include "BlockActorPool.h"
+#include "BlockInstancedRenderer.h"
+#include "BlockViewTable.h"
+#include "BlockDestroySoundAggregator.h"
 #include "MyPlayerController.generated.h"
 
 class BlockPhysics;
@@ -11,6 +16,7 @@ class PhysicalBlockSnapShot;
 class AActor;
 class Block;
 enum class ActionType;
+enum class BlockSpecialAttribute;
 class UPaperSprite;
 class USoundWave;
 class Match;
@@ -30,6 +36,14 @@ public:
 
 	virtual void SetupInputComponent() override;
 
+	// Decodes the board's trace buffer to the log
+	UFUNCTION(Exec)
+	void DumpBlockPhysicsTrace();
+
+	// Logs how often block actors were reused rather than spawned
+	UFUNCTION(Exec)
+	void DumpBlockActorPoolStats();
+
 #pragma region Drag functionality
 public:
 	TWeakObjectPtr<AActor> GetBlockUnderCursor(bool Debug = true);
@@ -56,7 +70,8 @@ public:
 	constexpr static int NUM_NORMAL_BLOCK_TYPES = 6;
 	UPROPERTY(EditAnywhere, Category = Block)
 	TSubclassOf<class AActor> blockActorBlueprintType[NUM_NORMAL_BLOCK_TYPES];
-	constexpr static int NUM_SPECIAL_BLOCK_TYPES = 1;
+	// rollable, then one color clear
+	constexpr static int NUM_SPECIAL_BLOCK_TYPES = 2;
 	UPROPERTY(EditAnywhere, Category = Block)
 	TSubclassOf<class AActor> specialBlockActorBlueprintType[NUM_SPECIAL_BLOCK_TYPES];
 	UPROPERTY(EditAnywhere, Category = Block)
@@ -68,27 +83,71 @@ public:
 	USoundWave* normalBlockPopSounds[NUM_NORMAL_BLOCK_POP_SOUNDS];
 	UPROPERTY(EditAnywhere, Category = BlockSound)
 	USoundWave* specialBlockPopSound;
+	// A line clear pops a whole row at once; the pops of a tick share this many sounds at most.
+	UPROPERTY(EditAnywhere, Category = BlockSound)
+	int maxDestroySoundVoicesPerTick = 3;
 	UPROPERTY(EditAnywhere, Category = BlockOrganization)
 	float GRID_SIZE = 60.0f;
 	UPROPERTY(EditAnywhere, Category = BlockOrganization)
 	float DEFAULT_DEPTH = -500.0f;
+	// Draws every block type as one instanced component instead of an actor per block, for big boards.
+	// Explosions are drawn as a still sprite then.
+	UPROPERTY(EditAnywhere, Category = BlockRendering)
+	bool useInstancedBlockRendering = false;
+	UPROPERTY(EditAnywhere, Category = BlockRendering)
+	UPaperSprite* blockSprites[NUM_NORMAL_BLOCK_TYPES];
+	UPROPERTY(EditAnywhere, Category = BlockRendering)
+	UPaperSprite* specialBlockSprites[NUM_SPECIAL_BLOCK_TYPES];
+	UPROPERTY(EditAnywhere, Category = BlockRendering)
+	UPaperSprite* explosionSprite;
 
 private:
 	void SpawnInitialBlocks();
 	void SpawnBlockActor(const PhysicalBlockSnapShot& physicalBlockSnapShot);
-	AActor* SpawnBlockActor(const PhysicalBlockSnapShot& physicalBlockSnapShot, const FVector* spawnPosition, const FRotator* spawnRotation);
-	void PlayDestroySoundIfNeeded(const PhysicalBlockSnapShot& updatedPhysicalBlock);
-	void PlaySpecialDestroySound();
-	void RandomlyPlayNormalDestorySound();
-	void UpdateBlockStatus(AActor* pBlock, const PhysicalBlockSnapShot& updatedPhysicalBlock);
+	// Spawns a new actor of the kind, hidden in the pool, for every actor the board could need at once
+	void PrewarmBlockActorPool();
+	AActor* SpawnNewBlockActor(int actorKind, const FVector& spawnPosition, const FRotator& spawnRotation);
+	int GetActorKind(const PhysicalBlockSnapShot& physicalBlockSnapShot) const;
+	int GetNumActorsToPrewarm(int actorKind) const;
+	static FRotator GetDecoratorRotation(BlockSpecialAttribute decorator);
+	FVector GetBlockWorldPosition(const PhysicalBlockSnapShot& physicalBlockSnapShot);
+	// Plays the pops gathered from the published delta, a few voices for the whole tick
+	void PlayDestroySounds();
+	void UpdateBlockStatus(BlockViewTable::Slot& blockView, const PhysicalBlockSnapShot& updatedPhysicalBlock);
 	void UpdateBlocks();
-	void DeleteBlockActor(int blockId);
+	// Brings a dirty block view in line with the block's latest snapshot
+	void UpdateBlockActor(BlockViewTable::Slot& blockView);
+	// Hands the block's actor back to the pool
+	void DeleteBlockActor(BlockViewTable::Slot& blockView);
+
+	void InitializeInstancedRenderer();
+	void ShowInstancedBlock(const PhysicalBlockSnapShot& physicalBlockSnapShot);
+	// Draws the ribbon of a decorated block in front of it, in both rendering modes
+	void ShowDecorator(const PhysicalBlockSnapShot& physicalBlockSnapShot, const FVector& blockPosition);
+	void UpdateInstancedBlock(BlockViewTable::Slot& blockView);
 
 	void AddScore(int score);
-	static int ComputeScore(const TSet<Match>& matches);
 
 	BlockPhysics* blockPhysics;
-	TMap<int, AActor*> idToBlockActorMap;
-	TMap<int, ActionType> idToActionTypeMap;
+	bool areInitialBlocksSpawned = false;
+	// actor, pool kind and last drawn action of each block, by handle index
+	BlockViewTable blockViews;
+	BlockDestroySoundAggregator destroySoundAggregator;
+	TArray<BlockDestroySoundAggregator::Voice> destroySoundVoices;
+
+	// Actor kinds: normal colors, decorated blocks included, then specials, then the explosion
+	constexpr static int FIRST_SPECIAL_ACTOR_KIND = NUM_NORMAL_BLOCK_TYPES;
+	constexpr static int EXPLOSION_ACTOR_KIND = FIRST_SPECIAL_ACTOR_KIND + NUM_SPECIAL_BLOCK_TYPES;
+	constexpr static int NUM_ACTOR_KINDS = EXPLOSION_ACTOR_KIND + 1;
+	constexpr static int NUM_SPECIAL_ACTORS_TO_PREWARM = 2;
+	BlockActorPool blockActorPool;
+
+	// Instanced layers: normal colors, then specials, then the explosion, then the ribbon over decorated blocks.
+	// Without instanced rendering only the ribbon layer is used.
+	constexpr static int FIRST_SPECIAL_LAYER = NUM_NORMAL_BLOCK_TYPES;
+	constexpr static int EXPLOSION_LAYER = FIRST_SPECIAL_LAYER + NUM_SPECIAL_BLOCK_TYPES;
+	constexpr static int RIBBON_LAYER = EXPLOSION_LAYER + 1;
+	constexpr static int NUM_LAYERS = RIBBON_LAYER + 1;
+	BlockInstancedRenderer instancedRenderer;
 #pragma endregion
 };
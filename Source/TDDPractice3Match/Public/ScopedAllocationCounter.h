@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Counts heap allocations made on the constructing thread while it is alive. The first counter wraps GMalloc
+// with a forwarding allocator that stays installed for the rest of the process; allocations on other threads
+// are forwarded without being counted. Counters may nest.
+class TDDPRACTICE3MATCH_API ScopedAllocationCounter {
+public:
+	ScopedAllocationCounter();
+	~ScopedAllocationCounter();
+	ScopedAllocationCounter(const ScopedAllocationCounter& other) = delete;
+	ScopedAllocationCounter& operator=(const ScopedAllocationCounter& other) = delete;
+
+	uint64 GetNumAllocations() const;
+	uint64 GetNumAllocatedBytes() const;
+	void Restart();
+
+	// false if GMalloc did not exist yet when the counter was created
+	static bool IsCounting();
+private:
+	uint64 numAllocationsAtStart = 0;
+	uint64 numAllocatedBytesAtStart = 0;
+};
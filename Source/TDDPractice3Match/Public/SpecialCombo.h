@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Block.h"
+
+class ExplosionMask;
+
+enum class SpecialComboType : uint8 {
+	None,
+	// resolved through the one color clears' own explosions
+	OneColorClear,
+	Cross,
+	WideCross,
+	BigDiamond,
+	RollingLineClear
+};
+
+// What swapping two blocks sets off instead of the normal match path, looked up by their pair of attributes.
+class TDDPRACTICE3MATCH_API SpecialCombo {
+public:
+	using EffectFunction = void(*)(ExplosionMask& explosionMask, FIntPoint firstCell, FIntPoint secondCell);
+
+	static const SpecialCombo& Find(BlockSpecialAttribute firstAttribute, BlockSpecialAttribute secondAttribute);
+	SpecialComboType GetType() const { return type; }
+	bool HasCellEffect() const { return effect != nullptr; }
+	// firstCell holds the block with the first attribute given to Find
+	void AddEffectTo(ExplosionMask& explosionMask, FIntPoint firstCell, FIntPoint secondCell) const;
+private:
+	SpecialComboType type = SpecialComboType::None;
+	EffectFunction effect = nullptr;
+	// the table entry was registered with the attributes the other way around
+	bool isMirrored = false;
+};
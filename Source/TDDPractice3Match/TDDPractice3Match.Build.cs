@@ -10,7 +10,7 @@ public class TDDPractice3Match : ModuleRules
 	
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore" });
 
-        PrivateDependencyModuleNames.AddRange(new string[] { "Paper2D" });
+        PrivateDependencyModuleNames.AddRange(new string[] { "Paper2D", "Json" });
         PrivateIncludePathModuleNames.AddRange(new string[] { "Paper2D" });
 	}
 }
@@ -22,6 +22,7 @@ void FTDDPractice3MatchModuleImpl::ShutdownModule() {
 	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("MunchickenShouldBeGenerated"));
 	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("SwipeOnMunchickenShouldRollIt"));
 	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("SwipeOnMunchickenShouldRollItForFrequentTick"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("MunchickenShouldNotTunnelPastCellsInALongTick"));
 	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("MunchickenShouldBeGeneratedAtBlockInflowPosition"));
 	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("MunchickenVerticalRollShouldNotSpawnNewBlocks"));
 	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("MunchickenShouldFallIfIdle"));
@@ -32,6 +33,35 @@ void FTDDPractice3MatchModuleImpl::ShutdownModule() {
 	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("LineClearerShouldClearALineOnDestroy"));
 	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("OnlyOneSpecialBlockShouldBeGeneratedEvenIfManyCandidatePositions"));
 	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("BlockPhysicsShouldReturnInActionWhenBlockMoving"));	
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("RestoredRandomStateShouldRepeatSequence"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("SameSeedShouldRefillSameBlocks"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("BlockHandlesShouldSurviveRemovalOfOtherBlocks"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("TraceShouldRecordMatchedBlockDestruction"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("SettledBoardShouldNotAllocate"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("SwipeShouldStayWithinAllocationBudget"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("CascadeShouldStayWithinAllocationBudget"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("PublishedSnapShotsShouldFollowTicks"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("PublishedDeltaShouldReproduceSnapShots"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("BlockViewsShouldFollowPublishedDeltas"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("DestroySoundsShouldBeVoiceLimited"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("SegmentQueriesShouldFindBlocksBetweenLatticePoints"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("SegmentQueriesShouldHitBlockBodiesOffTheLattice"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("LogicalGridShouldHoldIdleBlocks"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("LoadedStateShouldResumeMidCascade"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("ClonedBoardShouldBranchIndependently"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("BotShouldScoreOnlyMatchingSwipes"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("BotShouldKeepItsTimeBudgetOnALargeBoard"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("BoardHashShouldFollowBoardContents"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("ParallelMatchScanShouldEqualSerialScan"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("ExplosionMaskShouldCoverItsRowsColumnsAndCells"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("OneByFiveMatchShouldSpawnOneColorClear"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("OneColorClearShouldClearTheColorSwipedWith"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("OneColorClearsSwipedTogetherShouldClearTwoColors"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("LShapeMatchShouldSpawnDiamondClear"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("DiamondClearShouldClearItsDiamondOnDestroy"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("DiamondClearShouldClearFallingBlocksInItsDiamond"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("SwappedLineClearersShouldClearACross"));
+	FAutomationTestFramework::Get().UnregisterAutomationTest(TEXT("MunchickenSwappedWithLineClearerShouldRollALineClear"));
 	
 	
 	UE_LOG(LogTemp, Warning, TEXT("ShoutdownModule"));